@@ -28,6 +28,7 @@
 #include "Preprocessing/CHBuilder.h"
 
 #include "../../DataStructures/Graph/Graph.h"
+#include "../../Helpers/Vector/Permutation.h"
 #include "../../Helpers/Ranges/IndirectEdgeRange.h"
 #include "../../Helpers/Ranges/ConcatenatedRange.h"
 #include "../../Helpers/Ranges/Range.h"
@@ -121,6 +122,11 @@ public:
         return false;
     }
 
+    inline void applyVertexPermutation(const Permutation& permutation) noexcept {
+        forward.applyVertexPermutation(permutation);
+        backward.applyVertexPermutation(permutation);
+    }
+
     // IO:
     inline void writeBinary(const std::string& fileName, const std::string& separator = ".") const noexcept {
         forward.writeBinary(fileName + separator + "forward", separator);
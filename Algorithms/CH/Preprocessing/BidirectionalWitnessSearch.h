@@ -54,6 +54,7 @@ public:
     BidirectionalWitnessSearch() :
         graph(0),
         weight(0),
+        excludedVertices(nullptr),
         Q {ExternalKHeap<2, Distance>(), ExternalKHeap<2, Distance>()},
         distance {std::vector<Distance>(), std::vector<Distance>()},
         settled {std::vector<Vertex>(), std::vector<Vertex>()} {
@@ -68,6 +69,14 @@ public:
         std::vector<Distance>(graph->numVertices()).swap(distance[1]);
     }
 
+    // Vertices flagged in excludedVertices are ignored by the witness search, as the via vertex is (used by the
+    // parallel contraction, where all the vertices of the current batch are contracted simultaneously).
+    inline void setExcludedVertices(const std::vector<bool>* excludedVertices) noexcept {
+        this->excludedVertices = excludedVertices;
+        currentFrom = noVertex;
+        currentVia = noVertex;
+    }
+
     inline bool shortcutIsNecessary(const Vertex from, const Vertex to, const Vertex via, const int shortcutDistance) noexcept {
         if (graph->outDegree(from) == 1) return true;
         if (graph->inDegree(to) == 1) return true;
@@ -132,18 +141,22 @@ private:
         if constexpr (DIRECTION == FORWARD) {
             for (Edge edge : graph->edgesFrom(u)) {
                 const Vertex v = graph->get(ToVertex, edge);
-                if (v == via) continue;
+                if (isExcluded(v, via)) continue;
                 relax<DIRECTION>(v, label->distance + (*weight)[edge], shortcutDistance);
             }
         } else {
             for (Edge edge : graph->edgesTo(u)) {
                 const Vertex v = graph->get(FromVertex, edge);
-                if (v == via) continue;
+                if (isExcluded(v, via)) continue;
                 relax<DIRECTION>(v, label->distance + (*weight)[edge], shortcutDistance);
             }
         }
     }
 
+    inline bool isExcluded(const Vertex vertex, const Vertex via) const noexcept {
+        return (vertex == via) || ((excludedVertices != nullptr) && (*excludedVertices)[vertex]);
+    }
+
     template<int DIRECTION>
     inline void relax(const Vertex v, const int newDistance, const int shortcutDistance) noexcept {
         if (distance[DIRECTION][v].distance > newDistance) {
@@ -156,6 +169,7 @@ private:
 private:
     const Graph* graph;
     const std::vector<int>* weight;
+    const std::vector<bool>* excludedVertices;
 
     ExternalKHeap<2, Distance> Q[2];
     std::vector<Distance> distance[2];
@@ -26,6 +26,7 @@
 #include <string>
 #include <fstream>
 #include <algorithm>
+#include <limits>
 
 #include "BidirectionalWitnessSearch.h"
 #include "CHData.h"
@@ -35,6 +36,7 @@
 #include "../../../DataStructures/Graph/Graph.h"
 #include "../../../DataStructures/Container/ExternalKHeap.h"
 
+#include "../../../Helpers/MultiThreading.h"
 #include "../../../Helpers/Timer.h"
 
 namespace CH {
@@ -111,6 +113,33 @@ public:
         std::cout << "Building CH took " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
     }
 
+    // Parallel contraction: in each step, all vertices whose key is smaller than the keys of their neighbors form an
+    // independent set, which is contracted at once. The witness searches (and the key updates) of a step run in
+    // parallel with thread-local witness searches and key functions, whereas the graph is only modified sequentially.
+    // Since the witness searches of a step avoid all the vertices of the step, the result is a valid CH, but its
+    // order (and its shortcuts) differ from the ones of the sequential contraction.
+    inline void run(const ThreadPinning& threadPinning) {
+        Timer timer;
+        initialize<true>();
+        omp_set_num_threads(threadPinning.numberOfThreads);
+        std::vector<WitnessSearch> witnessSearches(threadPinning.numberOfThreads, witnessSearch);
+        std::vector<KeyFunction> keyFunctions(threadPinning.numberOfThreads, keyFunction);
+        #pragma omp parallel
+        {
+            threadPinning.pinThread();
+            const size_t threadId = omp_get_thread_num();
+            witnessSearches[threadId].initialize(&(data.core), &(data.core[Weight]));
+        }
+        std::vector<Vertex> vertices;
+        for (const Vertex vertex : data.core.vertices()) {
+            data.level[vertex] = 0;
+            vertices.emplace_back(vertex);
+        }
+        updateKeysInParallel(vertices, witnessSearches, keyFunctions);
+        contractQVerticesInParallel(witnessSearches, keyFunctions);
+        std::cout << "Building CH (parallel with " << threadPinning.numberOfThreads << " threads) took " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
+    }
+
     inline void changeKey(const KeyFunction& keyFunction) noexcept {
         this->keyFunction = keyFunction;
         std::vector<Vertex> vertices;
@@ -219,6 +248,120 @@ private:
         }
     }
 
+    inline void contractQVerticesInParallel(std::vector<WitnessSearch>& witnessSearches, std::vector<KeyFunction>& keyFunctions) noexcept {
+        std::vector<bool> inCurrentStep(data.numVertices, false);
+        std::vector<Vertex> step;
+        std::vector<std::vector<Shortcut>> shortcuts;
+        std::vector<Vertex> neighbors;
+        while (!Q.empty()) {
+            keyFunction.update(*this);
+            if (stopCriterion(Q)) {break;}
+            collectIndependentSet(step);
+            if (step.empty()) {
+                // only vertices which cannot be contracted yet (see PartialKey) remain, as the sequential contraction does:
+                VertexLabel* vLabel = Q.extractFront();
+                contract(Vertex(vLabel - &(label[0])));
+                continue;
+            }
+            for (const Vertex vertex : step) {
+                inCurrentStep[vertex] = true;
+            }
+            shortcuts.resize(step.size());
+            #pragma omp parallel
+            {
+                WitnessSearch& localWitnessSearch = witnessSearches[omp_get_thread_num()];
+                localWitnessSearch.setExcludedVertices(&inCurrentStep);
+                #pragma omp for schedule(dynamic)
+                for (size_t i = 0; i < step.size(); i++) {
+                    collectShortcuts(step[i], localWitnessSearch, shortcuts[i]);
+                }
+                localWitnessSearch.setExcludedVertices(nullptr);
+            }
+            neighbors.clear();
+            for (size_t i = 0; i < step.size(); i++) {
+                Q.remove(&(label[step[i]]));
+                data.order.push_back(step[i]);
+                for (const Shortcut& shortcut : shortcuts[i]) {
+                    addShortcut(shortcut.from, shortcut.to, step[i], shortcut.weight);
+                }
+                moveEdgesToCH(step[i], neighbors);
+                inCurrentStep[step[i]] = false;
+            }
+            removeDuplicates(neighbors);
+            // the thread-local key functions may hold state which is modified by KeyFunction::update:
+            for (KeyFunction& localKeyFunction : keyFunctions) {
+                localKeyFunction = keyFunction;
+            }
+            updateKeysInParallel(neighbors, witnessSearches, keyFunctions);
+        }
+    }
+
+    // the vertices of Q whose (key, id) is smaller than the one of all their neighbors :
+    inline void collectIndependentSet(std::vector<Vertex>& step) noexcept {
+        step.clear();
+        const std::vector<VertexLabel*>& heap = Q.data();
+        #pragma omp parallel
+        {
+            std::vector<Vertex> localStep;
+            #pragma omp for schedule(static) nowait
+            for (size_t i = 0; i < static_cast<size_t>(Q.size()); i++) {
+                const Vertex vertex = Vertex(heap[i] - &(label[0]));
+                if (isLocalMinimum(vertex)) localStep.emplace_back(vertex);
+            }
+            #pragma omp critical
+            {
+                step.insert(step.end(), localStep.begin(), localStep.end());
+            }
+        }
+        std::sort(step.begin(), step.end());
+    }
+
+    inline bool isLocalMinimum(const Vertex vertex) const noexcept {
+        const KeyType key = label[vertex].key;
+        if (key == std::numeric_limits<KeyType>::max()) return false;
+        const auto isSmaller = [&](const Vertex neighbor) {
+            return (key < label[neighbor].key) || ((key == label[neighbor].key) && (vertex < neighbor));
+        };
+        for (const Edge edge : data.core.edgesFrom(vertex)) {
+            if (!isSmaller(data.core.get(ToVertex, edge))) return false;
+        }
+        for (const Edge edge : data.core.edgesTo(vertex)) {
+            if (!isSmaller(data.core.get(FromVertex, edge))) return false;
+        }
+        return true;
+    }
+
+    inline void updateKeysInParallel(const std::vector<Vertex>& vertices, std::vector<WitnessSearch>& witnessSearches, std::vector<KeyFunction>& keyFunctions) noexcept {
+        #pragma omp parallel
+        {
+            const size_t threadId = omp_get_thread_num();
+            KeyFunction& localKeyFunction = keyFunctions[threadId];
+            localKeyFunction.initialize(&data, &(witnessSearches[threadId]));
+            #pragma omp for schedule(dynamic, 64)
+            for (size_t i = 0; i < vertices.size(); i++) {
+                label[vertices[i]].key = localKeyFunction(vertices[i]);
+            }
+        }
+        for (const Vertex vertex : vertices) {
+            Q.update(&(label[vertex]));
+        }
+    }
+
+    inline void collectShortcuts(const Vertex vertex, WitnessSearch& localWitnessSearch, std::vector<Shortcut>& shortcuts) noexcept {
+        shortcuts.clear();
+        for (Edge first : data.core.edgesTo(vertex)) {
+            Vertex from = data.core.get(FromVertex, first);
+            for (Edge second : data.core.edgesFrom(vertex)) {
+                Vertex to = data.core.get(ToVertex, second);
+                if (from == to) continue;
+                const int shortcutWeight = data.core.get(Weight, first) + data.core.get(Weight, second);
+                if (localWitnessSearch.shortcutIsNecessary(from, to, vertex, shortcutWeight)) {
+                    shortcuts.push_back(Shortcut({from, to, shortcutWeight}));
+                }
+            }
+        }
+    }
+
     inline void contract(const Vertex vertex) noexcept {
         data.order.push_back(vertex);
         std::vector<Shortcut> shortcuts;
@@ -238,24 +381,36 @@ private:
                 addShortcut(shortcut.from, shortcut.to, vertex, shortcut.weight);
             }
         }
-        std::set<Vertex> neighbors;
+        std::vector<Vertex> neighbors;
+        moveEdgesToCH(vertex, neighbors);
+        removeDuplicates(neighbors);
+        for (Vertex neighbor : neighbors) {
+            label[neighbor].key = getKey(neighbor);
+            Q.update(&(label[neighbor]));
+        }
+    }
+
+    inline static void removeDuplicates(std::vector<Vertex>& vertices) noexcept {
+        std::sort(vertices.begin(), vertices.end());
+        vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    }
+
+    // moves the remaining edges of vertex from the core to the CH, and raises the level of its neighbors :
+    inline void moveEdgesToCH(const Vertex vertex, std::vector<Vertex>& neighbors) noexcept {
+        const uint16_t level = data.level[vertex] + 1;
         for (Edge edge : data.core.edgesFrom(vertex)) {
             Vertex to = data.core.get(ToVertex, edge);
             data.forwardCH.addEdge(vertex, to).set(ViaVertex, data.core.get(ViaVertex, edge)).set(Weight, data.core.get(Weight, edge));
-            neighbors.insert(to);
+            data.level[to] = std::max(data.level[to], level);
+            neighbors.emplace_back(to);
         }
         for (Edge edge : data.core.edgesTo(vertex)) {
             Vertex from = data.core.get(FromVertex, edge);
             data.backwardCH.addEdge(vertex, from).set(ViaVertex, data.core.get(ViaVertex, edge)).set(Weight, data.core.get(Weight, edge));
-            neighbors.insert(from);
+            data.level[from] = std::max(data.level[from], level);
+            neighbors.emplace_back(from);
         }
         data.core.isolateVertex(vertex);
-        const uint16_t level = data.level[vertex] + 1;
-        for (Vertex neighbor : neighbors) {
-            data.level[neighbor] = std::max(data.level[neighbor], level);
-            label[neighbor].key = getKey(neighbor);
-            Q.update(&(label[neighbor]));
-        }
     }
 
     inline void addShortcut(const Vertex from, const Vertex to, const Vertex via, const int shortcutWeight) noexcept {
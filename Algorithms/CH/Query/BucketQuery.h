@@ -24,12 +24,156 @@
 #include <vector>
 #include <string>
 
+#include <memory>
+#include <cstdint>
+
+#include <omp.h>
+
 #include "CHQuery.h"
 
 #include "../../../Helpers/Console/Progress.h"
+#include "../../../Helpers/IO/Serialization.h"
 
 namespace CH {
 
+// The bucket graphs of a BucketQuery: for every POI, an edge from each vertex of its upward search space (in the
+// opposite direction), with the corresponding distance. They only depend on the CH and on the POIs, hence they can be
+// computed once, written to disk, and shared (they are never modified after construction) by any number of BucketQuery
+// instances, each of which only owns its own query state. A checksum of the CH is stored with them.
+class BucketGraphs {
+
+public:
+    BucketGraphs() : endOfPOIs(0), chChecksum(0) {}
+
+    BucketGraphs(const std::string& fileName) :
+        endOfPOIs(0),
+        chChecksum(0) {
+        readBinary(fileName);
+    }
+
+    // Reads the bucket graphs and checks that they were built for ch, with the vertices below endOfPOIs as POIs.
+    BucketGraphs(const std::string& fileName, const CH& ch, const Vertex::ValueType endOfPOIs) :
+        BucketGraphs(fileName) {
+        Ensure(isBucketGraphsOf(ch, endOfPOIs), "The bucket graphs in " << fileName << " were not built for this CH and these " << endOfPOIs << " POIs!");
+    }
+
+    // The upward searches of the POIs are distributed among numberOfThreads threads, each with its own QUERY.
+    template<typename QUERY, typename GRAPH>
+    inline static BucketGraphs Build(const GRAPH& forward, const GRAPH& backward, const std::vector<int>& forwardWeight, const std::vector<int>& backwardWeight, const Vertex::ValueType endOfPOIs, const size_t numberOfThreads, const bool verbose = false) noexcept {
+        BucketGraphs result;
+        result.endOfPOIs = Vertex(endOfPOIs);
+        result.chChecksum = Checksum(forward, backward, forwardWeight, backwardWeight);
+        result.template build<QUERY, FORWARD, BACKWARD>(forward, backward, forwardWeight, backwardWeight, numberOfThreads, verbose);
+        result.template build<QUERY, BACKWARD, FORWARD>(forward, backward, forwardWeight, backwardWeight, numberOfThreads, verbose);
+        return result;
+    }
+
+    template<typename QUERY>
+    inline static BucketGraphs Build(const CH& ch, const Vertex::ValueType endOfPOIs, const size_t numberOfThreads, const bool verbose = false) noexcept {
+        return Build<QUERY>(ch.forward, ch.backward, ch.forward[Weight], ch.backward[Weight], endOfPOIs, numberOfThreads, verbose);
+    }
+
+    // FNV-1a of the edges (head and weight) of both directions of the CH, in the order of the graphs.
+    template<typename GRAPH>
+    inline static uint64_t Checksum(const GRAPH& forward, const GRAPH& backward, const std::vector<int>& forwardWeight, const std::vector<int>& backwardWeight) noexcept {
+        uint64_t result = 14695981039346656037ull;
+        const GRAPH* graphs[2] = {&forward, &backward};
+        const std::vector<int>* weights[2] = {&forwardWeight, &backwardWeight};
+        for (const int direction : {FORWARD, BACKWARD}) {
+            for (const Vertex from : graphs[direction]->vertices()) {
+                result = (result ^ uint64_t(graphs[direction]->beginEdgeFrom(from))) * 1099511628211ull;
+                for (const Edge edge : graphs[direction]->edgesFrom(from)) {
+                    result = (result ^ uint64_t(graphs[direction]->get(ToVertex, edge))) * 1099511628211ull;
+                    result = (result ^ uint64_t(uint32_t((*weights[direction])[edge]))) * 1099511628211ull;
+                }
+            }
+        }
+        return result;
+    }
+
+    // True if the bucket graphs were built for ch (up to collisions of the checksum), with endOfPOIs POIs.
+    inline bool isBucketGraphsOf(const CH& ch, const Vertex::ValueType endOfPOIs) const noexcept {
+        if (graph[FORWARD].numVertices() != ch.numVertices() || this->endOfPOIs != endOfPOIs) return false;
+        return chChecksum == Checksum(ch.forward, ch.backward, ch.forward[Weight], ch.backward[Weight]);
+    }
+
+    inline const CHGraph& getGraph(const int direction) const noexcept {
+        return graph[direction];
+    }
+
+    inline Vertex::ValueType getEndOfPOIs() const noexcept {
+        return endOfPOIs;
+    }
+
+    inline long long byteSize() const noexcept {
+        return graph[FORWARD].byteSize() + graph[BACKWARD].byteSize();
+    }
+
+    inline void writeBinary(const std::string& fileName, const std::string& separator = ".") const noexcept {
+        IO::serialize(fileName, endOfPOIs, graph[FORWARD].numVertices(), chChecksum);
+        graph[FORWARD].writeBinary(fileName + separator + "forward", separator);
+        graph[BACKWARD].writeBinary(fileName + separator + "backward", separator);
+    }
+
+    inline void readBinary(const std::string& fileName, const std::string& separator = ".") noexcept {
+        size_t numberOfVertices = 0;
+        IO::deserialize(fileName, endOfPOIs, numberOfVertices, chChecksum);
+        graph[FORWARD].readBinary(fileName + separator + "forward", separator);
+        graph[BACKWARD].readBinary(fileName + separator + "backward", separator);
+        Ensure(graph[FORWARD].numVertices() == numberOfVertices && graph[BACKWARD].numVertices() == numberOfVertices, "The bucket graphs in " << fileName << " are inconsistent!");
+        Ensure(endOfPOIs <= numberOfVertices, "The bucket graphs in " << fileName << " have more POIs than vertices!");
+        for (const int direction : {FORWARD, BACKWARD}) {
+            for (const Vertex poi : graph[direction][ToVertex]) {
+                Ensure(poi < endOfPOIs, "The bucket graphs in " << fileName << " contain an edge to " << poi << ", which is not a POI!");
+            }
+        }
+    }
+
+private:
+    template<typename QUERY, int I, int J, typename GRAPH>
+    inline void build(const GRAPH& forward, const GRAPH& backward, const std::vector<int>& forwardWeight, const std::vector<int>& backwardWeight, const size_t numberOfThreads, const bool verbose) noexcept {
+        if (verbose) std::cout << "Building " << ((I == FORWARD) ? ("forward") : ("backward")) << " bucket graph (parallel with " << numberOfThreads << " threads)" << std::endl;
+        // buckets[poi] = the vertices whose search space contains poi, written by the thread which searched from poi :
+        std::vector<std::vector<std::pair<Vertex, int>>> buckets(endOfPOIs);
+        Progress progress(endOfPOIs, verbose);
+        #pragma omp parallel num_threads(numberOfThreads)
+        {
+            QUERY query(forward, backward, forwardWeight, backwardWeight, forward.numVertices());
+            #pragma omp for schedule(dynamic, 64)
+            for (size_t i = 0; i < endOfPOIs; i++) {
+                const Vertex vertex = Vertex(i);
+                query.template run<J, I>(vertex);
+                for (const Vertex bucket : query.template getPOIs<J>()) {
+                    buckets[vertex].emplace_back(bucket, query.template getDistanceToPOI<J>(bucket));
+                }
+                progress++;
+            }
+        }
+        CHConstructionGraph temp;
+        temp.addVertices(forward.numVertices());
+        for (Vertex vertex = Vertex(0); vertex < endOfPOIs; vertex++) {
+            for (const std::pair<Vertex, int>& bucket : buckets[vertex]) {
+                AssertMsg(!temp.hasEdge(bucket.first, vertex), "Bucket graph contains already an edge from " << bucket.first << " to " << vertex << "!");
+                temp.addEdge(bucket.first, vertex).set(Weight, bucket.second);
+            }
+            std::vector<std::pair<Vertex, int>>().swap(buckets[vertex]);
+        }
+        ::Graph::move(std::move(temp), graph[I]);
+        graph[I].sortEdges(Weight);
+        if (verbose) {
+            std::cout << std::endl;
+            ::Graph::printInfo(graph[I]);
+            graph[I].printAnalysis();
+        }
+    }
+
+private:
+    CHGraph graph[2];
+    Vertex endOfPOIs;
+    uint64_t chChecksum;
+
+};
+
 template<typename GRAPH = CHGraph, bool STALL_ON_DEMAND = true, bool DEBUG = false>
 class BucketQuery {
 
@@ -42,15 +186,24 @@ public:
     using BaseQuery = Query<Graph, StallOnDemand, false, true>;
 
 public:
-    BucketQuery(const Graph& forward, const Graph& backward, const std::vector<int>& forwardWeight, const std::vector<int>& backwardWeight, const Vertex::ValueType endOfPOIs) :
+    BucketQuery(const Graph& forward, const Graph& backward, const std::vector<int>& forwardWeight, const std::vector<int>& backwardWeight, const std::shared_ptr<const BucketGraphs>& bucketGraphs) :
         baseQuery(forward, backward, forwardWeight, backwardWeight, forward.numVertices()),
-        bucketGraph {CHGraph(), CHGraph()},
+        bucketGraphs(bucketGraphs),
         distance {std::vector<int>(forward.numVertices(), INFTY), std::vector<int>(backward.numVertices(), INFTY)},
+        via {std::vector<Vertex>(forward.numVertices(), noVertex), std::vector<Vertex>(backward.numVertices(), noVertex)},
         root{noVertex, noVertex},
-        endOfPOIs(endOfPOIs),
         reachedPOIs {std::vector<Vertex>(), std::vector<Vertex>()} {
-        buildBucketGraph<FORWARD, BACKWARD>();
-        buildBucketGraph<BACKWARD, FORWARD>();
+        Ensure(bucketGraphs, "Bucket graphs are missing!");
+        Ensure(bucketGraphs->getGraph(FORWARD).numVertices() == forward.numVertices() && bucketGraphs->getGraph(BACKWARD).numVertices() == backward.numVertices(), "Bucket graphs do not match the CH!");
+    }
+
+    BucketQuery(const Graph& forward, const Graph& backward, const std::vector<int>& forwardWeight, const std::vector<int>& backwardWeight, const Vertex::ValueType endOfPOIs) :
+        BucketQuery(forward, backward, forwardWeight, backwardWeight, std::make_shared<const BucketGraphs>(BuildBucketGraphs(forward, backward, forwardWeight, backwardWeight, endOfPOIs))) {
+    }
+
+    template<typename ATTRIBUTE>
+    BucketQuery(const Graph& forward, const Graph& backward, const std::shared_ptr<const BucketGraphs>& bucketGraphs, const ATTRIBUTE attribute = Weight) :
+        BucketQuery(forward, backward, forward[attribute], backward[attribute], bucketGraphs) {
     }
 
     template<typename ATTRIBUTE>
@@ -62,6 +215,14 @@ public:
         BucketQuery(ch.getGraph(direction), ch.getGraph(!direction), endOfPOIs, Weight) {
     }
 
+    inline static BucketGraphs BuildBucketGraphs(const Graph& forward, const Graph& backward, const std::vector<int>& forwardWeight, const std::vector<int>& backwardWeight, const Vertex::ValueType endOfPOIs, const size_t numberOfThreads = omp_get_max_threads()) noexcept {
+        return BucketGraphs::Build<BaseQuery>(forward, backward, forwardWeight, backwardWeight, endOfPOIs, numberOfThreads, Debug);
+    }
+
+    inline static BucketGraphs BuildBucketGraphs(const CH& ch, const Vertex::ValueType endOfPOIs, const size_t numberOfThreads = omp_get_max_threads()) noexcept {
+        return BuildBucketGraphs(ch.forward, ch.backward, ch.forward[Weight], ch.backward[Weight], endOfPOIs, numberOfThreads);
+    }
+
     template<bool TARGET_PRUNING = true>
     inline void run(const Vertex from, const Vertex to) noexcept {
         if (root[FORWARD] == from && root[BACKWARD] == to) return;
@@ -96,14 +257,18 @@ public:
         root[J] = noVertex;
 
         clear<I>();
+        clear<J>();
         baseQuery.template run<I, J, TARGET_PRUNING>(origin);
         collectPOIs<I>();
 
         if constexpr (Debug) std::cout << "   Time = " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
     }
 
+    // Starts a query with several sources and/or targets (see addSource, addTarget and run()).
     inline void clear() noexcept {
         if constexpr (Debug) timer.restart();
+        root[FORWARD] = noVertex;
+        root[BACKWARD] = noVertex;
         clear<FORWARD>();
         clear<BACKWARD>();
         baseQuery.clear();
@@ -165,6 +330,35 @@ public:
         return reachedPOIs[BACKWARD];
     }
 
+    // All the vertices settled by the forward search (not only the POIs), and their distances from the source :
+    inline const std::vector<Vertex>& getForwardSearchSpace() const noexcept {
+        return baseQuery.template getPOIs<FORWARD>();
+    }
+
+    inline int getForwardSearchSpaceDistance(const Vertex vertex) noexcept {
+        return baseQuery.template getDistanceToPOI<FORWARD>(vertex);
+    }
+
+    // With several sources (respectively targets), the source from which a POI was reached (respectively the target
+    // reached from a POI), and the source and target of the shortest path :
+    inline Vertex getForwardOrigin(const Vertex vertex) const noexcept {
+        return getOrigin<FORWARD>(vertex);
+    }
+
+    inline Vertex getBackwardOrigin(const Vertex vertex) const noexcept {
+        return getOrigin<BACKWARD>(vertex);
+    }
+
+    inline Vertex getSource() const noexcept {
+        if (!reachable()) return noVertex;
+        return baseQuery.template getOrigin<FORWARD>(baseQuery.getIntersectingVertex());
+    }
+
+    inline Vertex getTarget() const noexcept {
+        if (!reachable()) return noVertex;
+        return baseQuery.template getOrigin<BACKWARD>(baseQuery.getIntersectingVertex());
+    }
+
     inline std::vector<Vertex> getReversePath(const Vertex = noVertex) const noexcept {
         return baseQuery.getReversePath();
     }
@@ -182,29 +376,6 @@ public:
     }
 
 private:
-    template<int I, int J>
-    inline void buildBucketGraph() noexcept {
-        if constexpr (Debug) std::cout << "Building " << ((I == FORWARD) ? ("forward") : ("backward")) << " bucket graph" << std::endl;
-        CHConstructionGraph temp;
-        temp.addVertices(distance[I].size());
-        Progress progress(endOfPOIs, Debug);
-        for (Vertex vertex = Vertex(0); vertex < endOfPOIs; vertex++) {
-            baseQuery.template run<J, I>(vertex);
-            for (const Vertex bucket : baseQuery.template getPOIs<J>()) {
-                AssertMsg(!temp.hasEdge(bucket, vertex), "Bucket graph contains already an edge from " << bucket << " to " << vertex << "!");
-                temp.addEdge(bucket, vertex).set(Weight, baseQuery.template getDistanceToPOI<J>(bucket));
-            }
-            progress++;
-        }
-        ::Graph::move(std::move(temp), bucketGraph[I]);
-        bucketGraph[I].sortEdges(Weight);
-        if constexpr (Debug) {
-            std::cout << std::endl;
-            ::Graph::printInfo(bucketGraph[I]);
-            bucketGraph[I].printAnalysis();
-        }
-    }
-
     template<int DIRECTION>
     inline void clear() noexcept {
         for (const Vertex vertex : reachedPOIs[DIRECTION]) {
@@ -213,21 +384,29 @@ private:
         reachedPOIs[DIRECTION].clear();
     }
 
+    template<int DIRECTION>
+    inline Vertex getOrigin(const Vertex vertex) const noexcept {
+        AssertMsg(distance[DIRECTION][vertex] != INFTY, "POI " << vertex << " was not reached!");
+        return baseQuery.template getOrigin<DIRECTION>(via[DIRECTION][vertex]);
+    }
+
     template<int DIRECTION>
     inline void collectPOIs() noexcept {
         const int maxDistance = baseQuery.getDistance();
         for (const Vertex vertex : baseQuery.template getPOIs<DIRECTION>()) {
             if (baseQuery.template getDistanceToPOI<DIRECTION>(vertex) > maxDistance) break;
-            for (const Edge edge : bucketGraph[DIRECTION].edgesFrom(vertex)) {
-                const int newDistance = baseQuery.template getDistanceToPOI<DIRECTION>(vertex) + bucketGraph[DIRECTION].get(Weight, edge);
+            const CHGraph& bucketGraph = bucketGraphs->getGraph(DIRECTION);
+            for (const Edge edge : bucketGraph.edgesFrom(vertex)) {
+                const int newDistance = baseQuery.template getDistanceToPOI<DIRECTION>(vertex) + bucketGraph.get(Weight, edge);
                 if (newDistance > maxDistance) break;
-                const Vertex poi = bucketGraph[DIRECTION].get(ToVertex, edge);
+                const Vertex poi = bucketGraph.get(ToVertex, edge);
                 if (distance[DIRECTION][poi] == INFTY) {
                     reachedPOIs[DIRECTION].emplace_back(poi);
-                    distance[DIRECTION][poi] = newDistance;
-                } else {
-                    distance[DIRECTION][poi] = std::min(distance[DIRECTION][poi], newDistance);
+                } else if (distance[DIRECTION][poi] <= newDistance) {
+                    continue;
                 }
+                distance[DIRECTION][poi] = newDistance;
+                via[DIRECTION][poi] = vertex;
             }
         }
     }
@@ -235,12 +414,13 @@ private:
 private:
     BaseQuery baseQuery;
 
-    CHGraph bucketGraph[2];
+    std::shared_ptr<const BucketGraphs> bucketGraphs;
     std::vector<int> distance[2];
+    // the vertex of the search space whose bucket gave the distance of the POI :
+    std::vector<Vertex> via[2];
 
     Vertex root[2];
 
-    Vertex endOfPOIs;
     std::vector<Vertex> reachedPOIs[2];
 
     Timer timer;
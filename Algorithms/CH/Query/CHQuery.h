@@ -91,6 +91,8 @@ public:
         clear();
         addSource(from);
         addTarget(to);
+        root[FORWARD] = from;
+        root[BACKWARD] = to;
         run<TARGET_PRUNING>();
     }
 
@@ -103,6 +105,7 @@ public:
         }
         clear<I>();
         addOrigin<I>(origin);
+        root[I] = origin;
         root[J] = noVertex;
         run<I, J, TARGET_PRUNING>();
     }
@@ -119,12 +122,22 @@ public:
         clearDirection<I>();
     }
 
+    // Several origins (with initial distances) can be added in each direction, the query then computes the shortest
+    // path from any source to any target. An origin can also be an origin of the other direction.
+    // Only run(from, to) and run<I, J>(origin) remember their roots (to skip a repeated query), hence a query with
+    // added origins is never skipped.
     template<int I>
     inline void addOrigin(const Vertex vertex, const int initialDistance = 0) noexcept {
-        root[I] = vertex;
         cleanLabel(vertex);
+        if (distance[I][vertex].distance <= initialDistance) return;
         distance[I][vertex].distance = initialDistance;
+        parent[I][vertex] = noVertex;
         Q[I].update(&distance[I][vertex]);
+        const int newTentativeDistance = initialDistance + distance[!I][vertex].distance;
+        if (tentativeDistance > newTentativeDistance) {
+            tentativeDistance = newTentativeDistance;
+            intersectingVertex = vertex;
+        }
     }
 
     inline void addSource(const Vertex vertex, const int initialDistance = 0) noexcept {
@@ -139,11 +152,6 @@ public:
     inline void run() noexcept {
         if constexpr (Debug) std::cout << "Running " << ((CollectPOIs) ? ("CH-POI") : ("CH")) << " query" << std::endl;
 
-        if (root[FORWARD] == root[BACKWARD]) {
-            tentativeDistance = 0;
-            intersectingVertex = root[FORWARD];
-        }
-
         while ((!Q[FORWARD].empty()) && (!Q[BACKWARD].empty())) {
             settle<FORWARD, BACKWARD, TARGET_PRUNING>();
             settle<BACKWARD, FORWARD, TARGET_PRUNING>();
@@ -164,11 +172,6 @@ public:
     inline void run() noexcept {
         if constexpr (Debug) std::cout << "Running unidirectional " << ((CollectPOIs) ? ("CH-POI") : ("CH")) << " query" << std::endl;
 
-        if (root[FORWARD] == root[BACKWARD]) {
-            tentativeDistance = 0;
-            intersectingVertex = root[FORWARD];
-        }
-
         while (!Q[I].empty()) {
             settle<I, J, TARGET_PRUNING>();
         }
@@ -196,6 +199,16 @@ public:
         return intersectingVertex;
     }
 
+    // The origin of the direction I from which the (settled) vertex was reached.
+    template<int I>
+    inline Vertex getOrigin(Vertex vertex) const noexcept {
+        AssertMsg(visited(vertex), "Vertex " << vertex << " was not reached!");
+        while (parent[I][vertex] != noVertex) {
+            vertex = parent[I][vertex];
+        }
+        return vertex;
+    }
+
     inline int getForwardDistance(const Vertex vertex) noexcept {
         cleanLabel(vertex);
         return distance[FORWARD][vertex].distance;
@@ -259,6 +272,8 @@ private:
         time++;
         tentativeDistance = INFTY;
         intersectingVertex = noVertex;
+        root[FORWARD] = noVertex;
+        root[BACKWARD] = noVertex;
     }
 
     template<int I>
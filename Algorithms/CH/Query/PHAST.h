@@ -0,0 +1,162 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "../CH.h"
+
+#include "../../../Helpers/Types.h"
+
+#include "../../../DataStructures/Container/ExternalKHeap.h"
+
+namespace CH {
+
+// One-to-all CH query (PHAST): an upward search from the sources (each with an initial distance), then a single sweep
+// over all the vertices, by decreasing rank, relaxing the downward edges. Hence the distances to all the vertices cost
+// one query, whatever the number of sources. The CH must not have a core.
+// The labels and the sweep order are only allocated by the first query, hence an unused PHAST costs nothing.
+template<typename GRAPH = CHGraph>
+class PHAST {
+
+public:
+    using Graph = GRAPH;
+    using Type = PHAST<Graph>;
+
+private:
+    struct Distance : public ExternalKHeapElement {
+        Distance() : ExternalKHeapElement(), distance(INFTY) {}
+        inline bool hasSmallerKey(const Distance* other) const noexcept {return distance < other->distance;}
+        int distance;
+    };
+
+public:
+    PHAST(const Graph& forward, const Graph& backward, const std::vector<int>& forwardWeight, const std::vector<int>& backwardWeight) :
+        forward(forward),
+        backward(backward),
+        forwardWeight(forwardWeight),
+        backwardWeight(backwardWeight),
+        Q(0) {
+        AssertMsg(forward.numVertices() == backward.numVertices(), "Number of vertices is inconsistent!");
+    }
+
+    template<typename ATTRIBUTE>
+    PHAST(const Graph& forward, const Graph& backward, const ATTRIBUTE attribute = Weight) :
+        PHAST(forward, backward, forward[attribute], backward[attribute]) {
+    }
+
+    PHAST(const CH& ch, const int direction = FORWARD) :
+        PHAST(ch.getGraph(direction), ch.getGraph(!direction), Weight) {
+    }
+
+    inline void clear() noexcept {
+        if (sweepOrder.size() != forward.numVertices()) initialize();
+        Q.clear();
+        for (Distance& label : distance) {
+            label.distance = INFTY;
+        }
+    }
+
+    inline void addSource(const Vertex vertex, const int initialDistance = 0) noexcept {
+        AssertMsg(sweepOrder.size() == forward.numVertices(), "PHAST has to be cleared before adding sources!");
+        if (distance[vertex].distance <= initialDistance) return;
+        distance[vertex].distance = initialDistance;
+        Q.update(&distance[vertex]);
+    }
+
+    inline void run() noexcept {
+        while (!Q.empty()) {
+            settle();
+        }
+        // every edge of the backward graph leads to a higher vertex, which precedes its tail in the sweep order :
+        for (const Vertex vertex : sweepOrder) {
+            for (const Edge edge : backward.edgesFrom(vertex)) {
+                const int newDistance = distance[backward.get(ToVertex, edge)].distance + backwardWeight[edge];
+                if (distance[vertex].distance > newDistance) distance[vertex].distance = newDistance;
+            }
+        }
+    }
+
+    inline int getDistance(const Vertex vertex) const noexcept {
+        return distance[vertex].distance;
+    }
+
+private:
+    // The sweep order is a post-order of a depth first search along the (upward) edges of the backward graph.
+    inline void initialize() noexcept {
+        const size_t numberOfVertices = forward.numVertices();
+        distance = std::vector<Distance>(numberOfVertices);
+        Q.reserve(numberOfVertices);
+        sweepOrder.clear();
+        sweepOrder.reserve(numberOfVertices);
+        std::vector<bool> visited(numberOfVertices, false);
+        std::vector<std::pair<Vertex, Edge>> stack;
+        for (const Vertex root : backward.vertices()) {
+            if (visited[root]) continue;
+            visited[root] = true;
+            stack.emplace_back(root, backward.beginEdgeFrom(root));
+            while (!stack.empty()) {
+                const Vertex vertex = stack.back().first;
+                const Edge edge = stack.back().second;
+                if (edge == backward.endEdgeFrom(vertex)) {
+                    sweepOrder.emplace_back(vertex);
+                    stack.pop_back();
+                    continue;
+                }
+                stack.back().second = Edge(edge + 1);
+                const Vertex next = backward.get(ToVertex, edge);
+                if (visited[next]) continue;
+                visited[next] = true;
+                stack.emplace_back(next, backward.beginEdgeFrom(next));
+            }
+        }
+    }
+
+    inline void settle() noexcept {
+        const Distance* distanceU = Q.extractFront();
+        const Vertex u = Vertex(distanceU - &(distance[0]));
+        for (const Edge edge : forward.edgesFrom(u)) {
+            const Vertex v = forward.get(ToVertex, edge);
+            const int newDistance = distanceU->distance + forwardWeight[edge];
+            if (distance[v].distance > newDistance) {
+                distance[v].distance = newDistance;
+                Q.update(&distance[v]);
+            }
+        }
+    }
+
+private:
+    const Graph& forward;
+    const Graph& backward;
+    const std::vector<int>& forwardWeight;
+    const std::vector<int>& backwardWeight;
+
+    ExternalKHeap<2, Distance> Q;
+    std::vector<Distance> distance;
+
+    std::vector<Vertex> sweepOrder;
+
+};
+
+}
@@ -34,15 +34,18 @@
 #include "../../Helpers/Vector/Vector.h"
 #include "../../DataStructures/CSA/Data.h"
 #include "../../DataStructures/Container/ExternalKHeap.h"
+#include "../../DataStructures/Container/ExternalRadixHeap.h"
+#include "../../Helpers/Meta.h"
 
 namespace CSA {
 
-template<typename DEBUGGER>
+template<typename DEBUGGER, bool USE_RADIX_HEAP = false>
 class DijkstraCSA {
 
 public:
     using Debugger = DEBUGGER;
-    using Type = DijkstraCSA<Debugger>;
+    static constexpr bool UseRadixHeap = USE_RADIX_HEAP;
+    using Type = DijkstraCSA<Debugger, UseRadixHeap>;
     using TripFlag = ConnectionId;
 
 private:
@@ -63,7 +66,11 @@ private:
         inline bool hasSmallerKey(const DijkstraLabel* const other) const noexcept {
             return arrivalTime < other->arrivalTime;
         }
+        inline int getKey() const noexcept {
+            return arrivalTime;
+        }
     };
+    using Queue = Meta::IF<UseRadixHeap, ExternalRadixHeap<DijkstraLabel>, ExternalKHeap<2, DijkstraLabel>>;
 
 public:
     template<typename ATTRIBUTE>
@@ -249,7 +256,7 @@ private:
     std::vector<int> arrivalTime;
     std::vector<ParentLabel> parentLabel;
     std::vector<DijkstraLabel> dijkstraLabels;
-    ExternalKHeap<2, DijkstraLabel> queue;
+    Queue queue;
 
     Debugger debugger;
 
@@ -32,16 +32,18 @@
 #include "../../Helpers/Vector/Vector.h"
 
 #include "../../DataStructures/Container/ExternalKHeap.h"
+#include "../../DataStructures/Container/ExternalRadixHeap.h"
 #include "../../DataStructures/Container/Set.h"
 #include "../../DataStructures/Attributes/AttributeNames.h"
 
-template<typename GRAPH, bool DEBUG = false>
+template<typename GRAPH, bool DEBUG = false, bool USE_RADIX_HEAP = false>
 class Dijkstra {
 
 public:
     using Graph = GRAPH;
     static constexpr bool Debug = DEBUG;
-    using Type = Dijkstra<Graph, Debug>;
+    static constexpr bool UseRadixHeap = USE_RADIX_HEAP;
+    using Type = Dijkstra<Graph, Debug, UseRadixHeap>;
 
 public:
     struct VertexLabel : public ExternalKHeapElement {
@@ -54,11 +56,15 @@ public:
         inline bool hasSmallerKey(const VertexLabel* other) const {
             return distance < other->distance;
         }
+        inline int getKey() const noexcept {
+            return distance;
+        }
 
         int distance;
         Vertex parent;
         int timeStamp;
     };
+    using Queue = Meta::IF<UseRadixHeap, ExternalRadixHeap<VertexLabel>, ExternalKHeap<2, VertexLabel>>;
 
 public:
     Dijkstra(const GRAPH& graph, const std::vector<int>& weight) :
@@ -225,7 +231,7 @@ private:
     const GRAPH& graph;
     const std::vector<int>& weight;
 
-    ExternalKHeap<2, VertexLabel> Q;
+    Queue Q;
 
     std::vector<VertexLabel> label;
     int timeStamp;
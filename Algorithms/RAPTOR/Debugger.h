@@ -51,6 +51,8 @@ public:
     inline void stopScanRoutes() const noexcept {}
     inline void startRelaxTransfers() const noexcept {}
     inline void stopRelaxTransfers() const noexcept {}
+    inline void startInitialTransfers() const noexcept {}
+    inline void stopInitialTransfers() const noexcept {}
 
     inline void scanRoute(const RouteId) const noexcept {}
     inline void scanRouteSegment(const size_t) const noexcept {}
@@ -140,6 +142,14 @@ public:
         statistics.back().relaxTransfersTime = phaseTimer.elapsedMicroseconds() - phaseTime;
     }
 
+    inline void startInitialTransfers() noexcept {
+        startRelaxTransfers();
+    }
+
+    inline void stopInitialTransfers() noexcept {
+        stopRelaxTransfers();
+    }
+
     inline void scanRoute(const RouteId) noexcept {
         statistics.back().numberOfScannedRoutes++;
     }
@@ -295,4 +305,129 @@ private:
 
 };
 
+// Counts the same events as the TimeDebugger, but only keeps the totals of the last query in a few fixed fields (no
+// allocation, no output), so that it can stay enabled in a server. The phase times are in microseconds.
+class CountersDebugger : public NoDebugger {
+
+public:
+    inline void start() noexcept {
+        timer.restart();
+        phaseStart = 0.0;
+        initializationTime = 0.0;
+        initialTransfersTime = 0.0;
+        collectRoutesTime = 0.0;
+        scanRoutesTime = 0.0;
+        intermediateTransfersTime = 0.0;
+        totalTime = 0.0;
+        numberOfRounds = 0;
+        numberOfScannedRoutes = 0;
+        numberOfScannedRouteSegments = 0;
+        numberOfRelaxedEdges = 0;
+        numberOfUpdatedStopsByRoute = 0;
+        numberOfUpdatedStopsByTransfer = 0;
+    }
+    inline void done() noexcept {
+        totalTime = timer.elapsedMicroseconds();
+    }
+
+    inline void startInitialization() noexcept {
+        startPhase();
+    }
+    inline void doneInitialization() noexcept {
+        stopPhase(initializationTime);
+    }
+
+    inline void newRound() noexcept {
+        numberOfRounds++;
+    }
+
+    inline void startCollectRoutes() noexcept {
+        startPhase();
+    }
+    inline void stopCollectRoutes() noexcept {
+        stopPhase(collectRoutesTime);
+    }
+    inline void startScanRoutes() noexcept {
+        startPhase();
+    }
+    inline void stopScanRoutes() noexcept {
+        stopPhase(scanRoutesTime);
+    }
+    inline void startRelaxTransfers() noexcept {
+        startPhase();
+    }
+    inline void stopRelaxTransfers() noexcept {
+        stopPhase(intermediateTransfersTime);
+    }
+    inline void startInitialTransfers() noexcept {
+        startPhase();
+    }
+    inline void stopInitialTransfers() noexcept {
+        stopPhase(initialTransfersTime);
+    }
+
+    inline void scanRoute(const RouteId) noexcept {
+        numberOfScannedRoutes++;
+    }
+    inline void scanRouteSegment(const size_t) noexcept {
+        numberOfScannedRouteSegments++;
+    }
+
+    inline void relaxEdge(const Edge) noexcept {
+        numberOfRelaxedEdges++;
+    }
+    inline void relaxShortcut(const Vertex, const Vertex) noexcept {
+        numberOfRelaxedEdges++;
+    }
+
+    inline void updateStopByRoute(const StopId, const int) noexcept {
+        numberOfUpdatedStopsByRoute++;
+    }
+    inline void updateStopByTransfer(const StopId, const int) noexcept {
+        numberOfUpdatedStopsByTransfer++;
+    }
+
+    inline double getInitializationTime() const noexcept {return initializationTime;}
+    inline double getInitialTransfersTime() const noexcept {return initialTransfersTime;}
+    inline double getCollectRoutesTime() const noexcept {return collectRoutesTime;}
+    inline double getScanRoutesTime() const noexcept {return scanRoutesTime;}
+    inline double getIntermediateTransfersTime() const noexcept {return intermediateTransfersTime;}
+    inline double getTotalTime() const noexcept {return totalTime;}
+
+    inline size_t getNumberOfRounds() const noexcept {return numberOfRounds;}
+    inline size_t getNumberOfScannedRoutes() const noexcept {return numberOfScannedRoutes;}
+    inline size_t getNumberOfScannedRouteSegments() const noexcept {return numberOfScannedRouteSegments;}
+    inline size_t getNumberOfRelaxedEdges() const noexcept {return numberOfRelaxedEdges;}
+    inline size_t getNumberOfUpdatedStopsByRoute() const noexcept {return numberOfUpdatedStopsByRoute;}
+    inline size_t getNumberOfUpdatedStopsByTransfer() const noexcept {return numberOfUpdatedStopsByTransfer;}
+
+private:
+    inline void startPhase() noexcept {
+        phaseStart = timer.elapsedMicroseconds();
+    }
+
+    inline void stopPhase(double& phaseTime) noexcept {
+        phaseTime += timer.elapsedMicroseconds() - phaseStart;
+    }
+
+private:
+    Timer timer;
+    double phaseStart{0.0};
+
+    double initializationTime{0.0};
+    double initialTransfersTime{0.0};
+    double collectRoutesTime{0.0};
+    double scanRoutesTime{0.0};
+    double intermediateTransfersTime{0.0};
+    double totalTime{0.0};
+
+    size_t numberOfRounds{0};
+    size_t numberOfScannedRoutes{0};
+    size_t numberOfScannedRouteSegments{0};
+    size_t numberOfRelaxedEdges{0};
+    size_t numberOfUpdatedStopsByRoute{0};
+    size_t numberOfUpdatedStopsByTransfer{0};
+
+};
+
 }
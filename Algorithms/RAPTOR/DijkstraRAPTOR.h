@@ -32,15 +32,18 @@
 #include "../../DataStructures/Container/Set.h"
 #include "../../DataStructures/Container/Map.h"
 #include "../../DataStructures/Container/ExternalKHeap.h"
+#include "../../DataStructures/Container/ExternalRadixHeap.h"
+#include "../../Helpers/Meta.h"
 
 namespace RAPTOR {
 
-template<typename DEBUGGER>
+template<typename DEBUGGER, bool USE_RADIX_HEAP = false>
 class DijkstraRAPTOR {
 
 public:
     using Debugger = DEBUGGER;
-    using Type = DijkstraRAPTOR<Debugger>;
+    static constexpr bool UseRadixHeap = USE_RADIX_HEAP;
+    using Type = DijkstraRAPTOR<Debugger, UseRadixHeap>;
 
 public:
     struct EarliestArrivalLabel {
@@ -60,7 +63,11 @@ public:
         inline bool hasSmallerKey(const DijkstraLabel* const other) const noexcept {
             return arrivalTime < other->arrivalTime;
         }
+        inline int getKey() const noexcept {
+            return arrivalTime;
+        }
     };
+    using Queue = Meta::IF<UseRadixHeap, ExternalRadixHeap<DijkstraLabel>, ExternalKHeap<2, DijkstraLabel>>;
 
 public:
     template<typename ATTRIBUTE>
@@ -375,7 +382,7 @@ private:
     int sourceDepartureTime;
 
     std::vector<DijkstraLabel> label;
-    ExternalKHeap<2, DijkstraLabel> queue;
+    Queue queue;
 
     Debugger debugger;
 
@@ -24,11 +24,18 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <functional>
 #include <cassert>
+#include <memory>
 
 #include "InitialTransfers.h"
 
+#include "../CH/Query/PHAST.h"
+
+#include "../../DataStructures/RAPTOR/CompactStopEvents.h"
 #include "../../DataStructures/RAPTOR/Data.h"
+#include "../../DataStructures/RAPTOR/DepartureColumns.h"
+#include "../../DataStructures/RAPTOR/ShortcutWindows.h"
 #include "../../DataStructures/Container/Set.h"
 #include "../../DataStructures/Container/Map.h"
 
@@ -37,9 +44,17 @@
 
 #include "MyCustomUsage/Server/legs.h"
 #include "MyCustomUsage/Server/journey.h"
+#include "MyCustomUsage/Server/round_labels.h"
 
 namespace RAPTOR {
 
+// A stop at which a query between two locations may begin (or end), with the time needed to walk between the location
+// and the stop.
+struct AccessStop {
+    Vertex stop;
+    int walkingTime;
+};
+
 template<typename DEBUGGER = NoDebugger>
 class ULTRARAPTOR {
 
@@ -52,8 +67,12 @@ public:
     template<typename ATTRIBUTE>
     ULTRARAPTOR(const Data& data, const CHGraph& forwardGraph, const CHGraph& backwardGraph, const ATTRIBUTE weight, const Debugger& debuggerTemplate = Debugger()) :
         data(data),
+        numberOfVertices(forwardGraph.numVertices()),
+        shortcutGraph(&(data.transferGraph)),
+        shortcutGraphValidUntil(never),
         initialTransfers(forwardGraph, backwardGraph, data.numberOfStops(), weight),
-        earliestArrival(data.numberOfStops() + 1),
+        finalTransfers(forwardGraph, backwardGraph, weight),
+        rounds(data.numberOfStops() + 1),
         stopsUpdatedByRoute(data.numberOfStops() + 1),
         stopsUpdatedByTransfer(data.numberOfStops() + 1),
         routesServingUpdatedStops(data.numberOfRoutes()),
@@ -69,27 +88,126 @@ public:
         ULTRARAPTOR(data, chData.forward, chData.backward, Weight, debuggerTemplate) {
     }
 
+    // The bucket graphs are shared (not copied), hence several engines only cost their own query state.
+    ULTRARAPTOR(const Data& data, const CH::CH& chData, const std::shared_ptr<const CH::BucketGraphs>& bucketGraphs, const Debugger& debuggerTemplate = Debugger()) :
+        data(data),
+        numberOfVertices(chData.numVertices()),
+        shortcutGraph(&(data.transferGraph)),
+        shortcutGraphValidUntil(never),
+        initialTransfers(chData.forward, chData.backward, bucketGraphs, Weight),
+        finalTransfers(chData.forward, chData.backward, Weight),
+        rounds(data.numberOfStops() + 1),
+        stopsUpdatedByRoute(data.numberOfStops() + 1),
+        stopsUpdatedByTransfer(data.numberOfStops() + 1),
+        routesServingUpdatedStops(data.numberOfRoutes()),
+        sourceVertex(noVertex),
+        targetVertex(noVertex),
+        targetStop(noStop),
+        debugger(debuggerTemplate) {
+        AssertMsg(data.hasImplicitBufferTimes(), "Departure buffer times have to be implicit!");
+        Ensure(bucketGraphs->getEndOfPOIs() == data.numberOfStops(), "The bucket graphs were not built for the stops of the network!");
+        debugger.initialize(data);
+    }
+
 
     inline std::vector<myserver::Leg> run(const Vertex source, const int departureTime, const Vertex target, const size_t maxRounds = 50) noexcept {
         std::cout << "Processing request FROM " << source << " (" << data.stopData[source] << ") TO " << target << " (" << data.stopData[target] << ") AT " << departureTime << std::endl;
         debugger.start();
-        debugger.startInitialization();
-        clear();
-        initialize(source, departureTime, target);
-        debugger.doneInitialization();
-        relaxInitialTransfers(departureTime);
-        for (size_t i = 0; i < maxRounds; i++) {
-            debugger.newRound();
-            startNewRound();
-            collectRoutesServingUpdatedStops();
-            scanRoutes();
-            if (stopsUpdatedByRoute.empty()) break;
-            relaxIntermediateTransfers();
+        search(source, departureTime, target, maxRounds);
+        if (!isExact(rounds.earliest_arrival_time(targetStop))) search(source, departureTime, target, maxRounds, false);
+        debugger.done();
+        auto journey = myserver::build_legs(source, target, targetStop, departureTime, data, rounds);
+        return journey;
+    }
+
+    // Bicriteria query: the Pareto-optimal journeys w.r.t. (arrival time, number of trips), by increasing number of
+    // trips. Since the target prunes the search, the target is only labeled in a round when it improves on all the
+    // previous rounds, hence each of its labels is one of these journeys.
+    inline std::vector<myserver::ParetoJourney> runPareto(const Vertex source, const int departureTime, const Vertex target, const size_t maxRounds = 50) noexcept {
+        std::cout << "Processing pareto request FROM " << source << " (" << data.stopData[source] << ") TO " << target << " (" << data.stopData[target] << ") AT " << departureTime << std::endl;
+        return paretoSearch(source, departureTime, target, maxRounds);
+    }
+
+    // Bicriteria query between two locations: the journeys begin at any of the source stops and end at any of the target
+    // stops, and include the walking times of the accesses. All the stops are sources (respectively targets) of a single
+    // bucket-CH search, hence this costs one query, whatever the number of stops.
+    inline std::vector<myserver::ParetoJourney> runPareto(const std::vector<AccessStop>& sources, const int departureTime, const std::vector<AccessStop>& targets, const size_t maxRounds = 50) noexcept {
+        std::cout << "Processing pareto request FROM " << sources.size() << " stops TO " << targets.size() << " stops AT " << departureTime << std::endl;
+        return paretoSearch(sources, departureTime, targets, maxRounds);
+    }
+
+    // One-to-many query: a single search from the source, without target pruning, then the final transfers to all the
+    // vertices are computed at once (see computeFinalTransfers). Returns the earliest arrival time at each target (never
+    // if it is not reachable).
+    inline std::vector<int> runOneToMany(const Vertex source, const int departureTime, const std::vector<Vertex>& targets, const size_t maxRounds = 50) noexcept {
+        debugger.start();
+        search(source, departureTime, noVertex, maxRounds);
+        computeFinalTransfers(departureTime);
+        if (!finalTransfersAreExact(targets)) {
+            search(source, departureTime, noVertex, maxRounds, false);
+            computeFinalTransfers(departureTime);
+        }
+        debugger.done();
+        std::vector<int> arrivalTimes;
+        arrivalTimes.reserve(targets.size());
+        for (const Vertex target : targets) {
+            arrivalTimes.emplace_back(getArrivalTimeAfterFinalTransfer(target));
         }
+        return arrivalTimes;
+    }
 
+    // One-to-all query: the earliest arrival time at every vertex of the (full) transfer graph. Some vertices are almost
+    // always reached beyond the horizon of a window (or not at all), hence the shortcuts of the whole day are used.
+    inline std::vector<int> runOneToAll(const Vertex source, const int departureTime, const size_t maxRounds = 50) noexcept {
+        debugger.start();
+        search(source, departureTime, noVertex, maxRounds, false);
+        computeFinalTransfers(departureTime);
         debugger.done();
-        auto journey = myserver::build_legs(source, target, departureTime, data, initialTransfers, rounds);
-        return journey;
+        std::vector<int> arrivalTimes(numberOfVertices, never);
+        for (Vertex target = Vertex(0); target < numberOfVertices; target++) {
+            arrivalTimes[target] = getArrivalTimeAfterFinalTransfer(target);
+        }
+        return arrivalTimes;
+    }
+
+    // From now on, queries whose departure times are all within one of the windows only relax the (fewer) shortcuts of
+    // that window. A query whose best arrival at the target is beyond the horizon of the window is run again with the
+    // shortcuts of the whole day. The windows are shared, several engines can use the same ones.
+    inline void useShortcutWindows(const std::shared_ptr<const ShortcutWindows>& windows) noexcept {
+        AssertMsg(!windows || windows->isShortcutWindowsOf(data), "The shortcut windows were not computed for this network!");
+        shortcutWindows = windows;
+    }
+
+    // From now on, the routes are scanned using the (smaller) compact stop events, except for the routes that could not
+    // be compressed. The compact stop events are shared, several engines can use the same ones.
+    inline void useCompactStopEvents(const std::shared_ptr<const CompactStopEvents>& stopEvents) noexcept {
+        AssertMsg(!stopEvents || stopEvents->isCompactCopyOf(data), "The compact stop events were not built for this network!");
+        compactStopEvents = stopEvents;
+    }
+
+    // From now on, the earliest trip that can be caught is searched in the departure columns, for the routes that have
+    // them. The departure columns are shared, several engines can use the same ones.
+    inline void useDepartureColumns(const std::shared_ptr<const DepartureColumns>& columns) noexcept {
+        AssertMsg(!columns || columns->isCopyOf(data), "The departure columns were not built for this network!");
+        departureColumns = columns;
+    }
+
+    inline size_t getNumberOfVertices() const noexcept {
+        return numberOfVertices;
+    }
+
+    // Range query (rRAPTOR): one search per departure time of the interval, in decreasing order. The labels of every
+    // round are kept from one departure time to the next, hence each search only explores what improves on the later
+    // departures. Returns the Pareto-optimal journeys w.r.t. (departure time, arrival time, number of trips).
+    inline std::vector<myserver::ParetoJourney> runRange(const Vertex source, const int minDepartureTime, const int maxDepartureTime, const Vertex target, const size_t maxRounds = 50) noexcept {
+        std::cout << "Processing range request FROM " << source << " (" << data.stopData[source] << ") TO " << target << " (" << data.stopData[target] << ") BETWEEN " << minDepartureTime << " AND " << maxDepartureTime << std::endl;
+        return exactRangeSearch(source, minDepartureTime, maxDepartureTime, target, maxRounds);
+    }
+
+    // Range query between two locations (see runPareto for the accesses).
+    inline std::vector<myserver::ParetoJourney> runRange(const std::vector<AccessStop>& sources, const int minDepartureTime, const int maxDepartureTime, const std::vector<AccessStop>& targets, const size_t maxRounds = 50) noexcept {
+        std::cout << "Processing range request FROM " << sources.size() << " stops TO " << targets.size() << " stops BETWEEN " << minDepartureTime << " AND " << maxDepartureTime << std::endl;
+        return exactRangeSearch(sources, minDepartureTime, maxDepartureTime, targets, maxRounds);
     }
 
     inline const Debugger& getDebugger() const noexcept {
@@ -97,6 +215,46 @@ public:
     }
 
 private:
+    // The debugger is started once per query, so that it also accounts for the search with the shortcuts of the whole
+    // day when the shortcuts of a window were not sufficient :
+    template<typename ENDPOINT>
+    inline std::vector<myserver::ParetoJourney> exactRangeSearch(const ENDPOINT& source, const int minDepartureTime, const int maxDepartureTime, const ENDPOINT& target, const size_t maxRounds) noexcept {
+        debugger.start();
+        std::vector<myserver::ParetoJourney> journeys = rangeSearch(source, minDepartureTime, maxDepartureTime, target, maxRounds);
+        if (!journeysAreExact(journeys)) journeys = rangeSearch(source, minDepartureTime, maxDepartureTime, target, maxRounds, false);
+        debugger.done();
+        return journeys;
+    }
+
+    template<typename ENDPOINT>
+    inline std::vector<myserver::ParetoJourney> rangeSearch(const ENDPOINT& source, const int minDepartureTime, const int maxDepartureTime, const ENDPOINT& target, const size_t maxRounds, const bool allowShortcutWindow = true) noexcept {
+        debugger.startInitialization();
+        clear();
+        selectShortcutGraph(minDepartureTime, maxDepartureTime, allowShortcutWindow);
+        initialize(source, target);
+        debugger.doneInitialization();
+        computeInitialTransfers();
+
+        std::vector<myserver::ParetoJourney> journeys;
+        if (initialTransfers.getDistance() != INFTY) {
+            // walking directly doesn't depend on the departure time: it is reported once, leaving as late as possible.
+            restart();
+            initializeSource(maxDepartureTime);
+            relaxInitialTransfers(maxDepartureTime);
+            journeys.emplace_back(maxDepartureTime, maxDepartureTime + initialTransfers.getDistance(), 0, legsOfRound(0, maxDepartureTime));
+        }
+        std::vector<int> bestArrivalTimeOfRound;
+        for (const int departureTime : collectDepartureTimes(minDepartureTime, maxDepartureTime)) {
+            restart();
+            initializeSource(departureTime);
+            relaxInitialTransfers(departureTime);
+            runRounds(maxRounds);
+            collectRangeJourneys(departureTime, bestArrivalTimeOfRound, journeys);
+        }
+        std::reverse(journeys.begin(), journeys.end());
+        return journeys;
+    }
+
     template<bool RESET_CAPACITIES = false>
     inline void clear() noexcept {
         stopsUpdatedByRoute.clear();
@@ -104,11 +262,9 @@ private:
         routesServingUpdatedStops.clear();
         targetStop = StopId(data.numberOfStops());
         if constexpr (RESET_CAPACITIES) {
-            std::vector<myserver::Round>().swap(rounds);
-            std::vector<int>(earliestArrival.size(), never).swap(earliestArrival);
+            rounds = myserver::RoundLabels(data.numberOfStops() + 1);
         } else {
             rounds.clear();
-            Vector::fill(earliestArrival, never);
         }
     }
 
@@ -116,28 +272,221 @@ private:
         clear<true>();
     }
 
-    inline void initialize(const Vertex source, const int departureTime, const Vertex target) noexcept {
+    template<typename ENDPOINT>
+    inline void search(const ENDPOINT& source, const int departureTime, const ENDPOINT& target, const size_t maxRounds, const bool allowShortcutWindow = true) noexcept {
+        debugger.startInitialization();
+        clear();
+        selectShortcutGraph(departureTime, departureTime, allowShortcutWindow);
+        initialize(source, target);
+        initializeSource(departureTime);
+        debugger.doneInitialization();
+        computeInitialTransfers();
+        relaxInitialTransfers(departureTime);
+        runRounds(maxRounds);
+    }
+
+    // The journeys with fewer trips arrive later than the earliest arrival, each of them has to be exact (otherwise it
+    // may be wrong or dominated), hence the search is run again with the shortcuts of the whole day if one is not :
+    template<typename ENDPOINT>
+    inline std::vector<myserver::ParetoJourney> paretoSearch(const ENDPOINT& source, const int departureTime, const ENDPOINT& target, const size_t maxRounds) noexcept {
+        debugger.start();
+        search(source, departureTime, target, maxRounds);
+        std::vector<myserver::ParetoJourney> journeys = collectParetoJourneys(departureTime);
+        if (!journeysAreExact(journeys)) {
+            search(source, departureTime, target, maxRounds, false);
+            journeys = collectParetoJourneys(departureTime);
+        }
+        debugger.done();
+        return journeys;
+    }
+
+    // A single PHAST query whose sources are the vertices of the forward search of computeInitialTransfers (walking
+    // directly from the source) and the stops reached by the search, with their arrival times :
+    inline void computeFinalTransfers(const int departureTime) noexcept {
+        finalTransfers.clear();
+        for (const Vertex vertex : initialTransfers.getForwardSearchSpace()) {
+            finalTransfers.addSource(vertex, departureTime + initialTransfers.getForwardSearchSpaceDistance(vertex));
+        }
+        for (const StopId stop : data.stops()) {
+            const int stopArrivalTime = rounds.earliest_arrival_time(stop);
+            if (stopArrivalTime == never) continue;
+            finalTransfers.addSource(stop, stopArrivalTime);
+        }
+        finalTransfers.run();
+    }
+
+    // arrival at target, either walking directly from the source, or walking from any stop reached by the search :
+    inline int getArrivalTimeAfterFinalTransfer(const Vertex target) const noexcept {
+        const int arrivalTime = finalTransfers.getDistance(target);
+        return (arrivalTime == INFTY) ? never : arrivalTime;
+    }
+
+    inline void selectShortcutGraph(const int minDepartureTime, const int maxDepartureTime, const bool allowShortcutWindow) noexcept {
+        shortcutGraph = &(data.transferGraph);
+        shortcutGraphValidUntil = never;
+        if (!shortcutWindows || !allowShortcutWindow) return;
+        const size_t window = shortcutWindows->find(minDepartureTime, maxDepartureTime);
+        if (window == ShortcutWindows::NoWindow) return;
+        shortcutGraph = &(shortcutWindows->shortcutGraph(window));
+        shortcutGraphValidUntil = shortcutWindows->validUntil(window);
+    }
+
+    // The shortcuts of a window only yield the earliest arrivals up to the end of its horizon (those of the whole day
+    // are always exact), a later or missing arrival may be improved by the shortcuts of the whole day :
+    inline bool isExact(const int arrivalTime) const noexcept {
+        return arrivalTime <= shortcutGraphValidUntil;
+    }
+
+    inline bool finalTransfersAreExact(const std::vector<Vertex>& targets) const noexcept {
+        if (shortcutGraphValidUntil == never) return true;
+        for (const Vertex target : targets) {
+            if (!isExact(getArrivalTimeAfterFinalTransfer(target))) return false;
+        }
+        return true;
+    }
+
+    inline bool journeysAreExact(const std::vector<myserver::ParetoJourney>& journeys) const noexcept {
+        if (shortcutGraphValidUntil == never) return true;
+        if (journeys.empty()) return false;
+        for (const myserver::ParetoJourney& journey : journeys) {
+            if (!isExact(journey.arrival_time)) return false;
+        }
+        return true;
+    }
+
+    inline void restart() noexcept {
+        stopsUpdatedByRoute.clear();
+        stopsUpdatedByTransfer.clear();
+        routesServingUpdatedStops.clear();
+        rounds.restart();
+    }
+
+    inline void initialize(const Vertex source, const Vertex target) noexcept {
         sourceVertex = source;
         targetVertex = target;
+        sourceStops.clear();
+        targetStops.clear();
         if (data.isStop(target)) {
             targetStop = StopId(target);
         }
+    }
+
+    // the journeys begin (respectively end) at the access stops, there is no source (respectively target) vertex :
+    inline void initialize(const std::vector<AccessStop>& sources, const std::vector<AccessStop>& targets) noexcept {
+        AssertMsg(!sources.empty() && !targets.empty(), "A query needs at least one source stop and one target stop!");
+        sourceVertex = noVertex;
+        targetVertex = noVertex;
+        sourceStops = sources;
+        targetStops = targets;
+        for (const AccessStop& access : sourceStops) {
+            AssertMsg(data.isStop(access.stop), "Source access " << access.stop << " is not a stop!");
+        }
+        for (const AccessStop& access : targetStops) {
+            AssertMsg(data.isStop(access.stop), "Target access " << access.stop << " is not a stop!");
+        }
+    }
+
+    // The journeys to stop begin at the source vertex, or at the access stop from which it is reached :
+    inline Vertex sourceOf(const Vertex stop) const noexcept {
+        return sourceStops.empty() ? sourceVertex : initialTransfers.getForwardOrigin(stop);
+    }
+
+    inline Vertex sourceOfDirectWalk() const noexcept {
+        return sourceStops.empty() ? sourceVertex : initialTransfers.getSource();
+    }
+
+    // The journey reaching the target in the given round ends at the target vertex, or at the access stop reached from
+    // its last stop (round 0 is the direct walk) :
+    inline Vertex targetOfRound(const size_t round) const noexcept {
+        if (targetStops.empty()) return targetVertex;
+        if (round == 0) return initialTransfers.getTarget();
+        return initialTransfers.getBackwardOrigin(rounds.label(round, targetStop).parent);
+    }
+
+    inline std::vector<myserver::Leg> legsOfRound(const size_t round, const int departureTime) const noexcept {
+        return myserver::build_legs_of_round(sourceVertex, targetOfRound(round), targetStop, round, departureTime, data, rounds);
+    }
+
+    inline std::vector<myserver::ParetoJourney> collectParetoJourneys(const int departureTime) const noexcept {
+        std::vector<myserver::ParetoJourney> journeys;
+        for (size_t round = 0; round < rounds.size(); round++) {
+            const int arrivalTime = rounds.arrival_time(round, targetStop);
+            if (arrivalTime == never) continue;
+            journeys.emplace_back(departureTime, arrivalTime, round, legsOfRound(round, departureTime));
+        }
+        return journeys;
+    }
+
+    inline void initializeSource(const int departureTime) noexcept {
         startNewRound();
-        if (data.isStop(source)) {
-            debugger.updateStopByRoute(StopId(source), departureTime);
-            arrivalByRoute(StopId(source), departureTime);
-            currentRound()[source].parent = source;
-            currentRound()[source].parentDepartureTime = departureTime;
-            currentRound()[source].usesRoute = false;
-            stopsUpdatedByTransfer.insert(StopId(source));
+        if (data.isStop(sourceVertex)) {
+            debugger.updateStopByRoute(StopId(sourceVertex), departureTime);
+            if (!arrivalByRoute(StopId(sourceVertex), departureTime)) return;
+            myserver::ParentLabel& label = rounds.current_parent(sourceVertex);
+            label.parent = sourceVertex;
+            label.parentDepartureTime = departureTime;
+            label.usesRoute = false;
+            stopsUpdatedByTransfer.insert(StopId(sourceVertex));
+        }
+    }
+
+    inline void runRounds(const size_t maxRounds) noexcept {
+        for (size_t i = 0; i < maxRounds; i++) {
+            debugger.newRound();
+            startNewRound();
+            collectRoutesServingUpdatedStops();
+            scanRoutes();
+            if (stopsUpdatedByRoute.empty()) break;
+            relaxIntermediateTransfers();
+        }
+    }
+
+    // departure times at the source for which some trip can be caught (directly, or after the initial transfer) :
+    inline std::vector<int> collectDepartureTimes(const int minDepartureTime, const int maxDepartureTime) const noexcept {
+        std::vector<int> departureTimes;
+        const auto collect = [&](const StopId stop, const int transferTime) {
+            for (const RouteSegment& route : data.routesContainingStop(stop)) {
+                if (route.stopIndex + 1 == data.numberOfStopsInRoute(route.routeId)) continue;
+                const size_t tripSize = data.numberOfStopsInRoute(route.routeId);
+                for (const StopEvent* trip = data.firstTripOfRoute(route.routeId); trip <= data.lastTripOfRoute(route.routeId); trip += tripSize) {
+                    const int departureTime = trip[route.stopIndex].departureTime - transferTime;
+                    if (departureTime < minDepartureTime) continue;
+                    if (departureTime > maxDepartureTime) break;
+                    departureTimes.emplace_back(departureTime);
+                }
+            }
+        };
+        if (data.isStop(sourceVertex)) collect(StopId(sourceVertex), 0);
+        for (const Vertex stop : initialTransfers.getForwardPOIs()) {
+            if (stop == targetStop || stop == sourceVertex) continue;
+            collect(StopId(stop), initialTransfers.getForwardDistance(stop));
+        }
+        std::sort(departureTimes.begin(), departureTimes.end(), std::greater<int>());
+        departureTimes.erase(std::unique(departureTimes.begin(), departureTimes.end()), departureTimes.end());
+        return departureTimes;
+    }
+
+    // the target was improved in round k iff its label is better than the ones of all later departure times (and than
+    // the ones with fewer trips, which would dominate it). Round 0 is the direct walk, which was already reported :
+    inline void collectRangeJourneys(const int departureTime, std::vector<int>& bestArrivalTimeOfRound, std::vector<myserver::ParetoJourney>& journeys) noexcept {
+        int bestArrivalTimeWithFewerTrips = never;
+        for (size_t round = 0; round < rounds.size(); round++) {
+            if (round == bestArrivalTimeOfRound.size()) bestArrivalTimeOfRound.emplace_back(never);
+            const int arrivalTime = rounds.arrival_time(round, targetStop);
+            if (round > 0 && arrivalTime < bestArrivalTimeOfRound[round] && arrivalTime < bestArrivalTimeWithFewerTrips) {
+                journeys.emplace_back(departureTime, arrivalTime, round, legsOfRound(round, departureTime));
+            }
+            bestArrivalTimeOfRound[round] = std::min(bestArrivalTimeOfRound[round], arrivalTime);
+            bestArrivalTimeWithFewerTrips = std::min(bestArrivalTimeWithFewerTrips, bestArrivalTimeOfRound[round]);
         }
     }
 
     inline void collectRoutesServingUpdatedStops() noexcept {
         debugger.startCollectRoutes();
+        const int* previousArrivalTimes = previousRound();
         for (const StopId stop : stopsUpdatedByTransfer) {
             AssertMsg(data.isStop(stop), "Stop " << stop << " is out of range!");
-            const int arrivalTime = previousRound()[stop].arrivalTime;
+            const int arrivalTime = previousArrivalTimes[stop];
             AssertMsg(arrivalTime < never, "Updated stop has arrival time = never!");
             for (const RouteSegment& route : data.routesContainingStop(stop)) {
                 AssertMsg(data.isRoute(route.routeId), "Route " << route.routeId << " is out of range!");
@@ -157,43 +506,92 @@ private:
     inline void scanRoutes() noexcept {
         debugger.startScanRoutes();
         stopsUpdatedByRoute.clear();
+        const int* previousArrivalTimes = previousRound();
         for (const RouteId route : routesServingUpdatedStops.getKeys()) {
             debugger.scanRoute(route);
-            StopIndex stopIndex = routesServingUpdatedStops[route];
+            const StopIndex stopIndex = routesServingUpdatedStops[route];
             const size_t tripSize = data.numberOfStopsInRoute(route);
             AssertMsg(stopIndex < tripSize - 1, "Cannot scan a route starting at/after the last stop (Route: " << route << ", StopIndex: " << stopIndex << ", TripSize: " << tripSize << ")!");
+            if (compactStopEvents && compactStopEvents->isCompactRoute(route)) {
+                // The times of a stop event are the base time of its trip plus its offsets:
+                const int* tripBases = compactStopEvents->tripBasesOfRoute(route);
+                const CompactStopEvents::Offsets* offsets = compactStopEvents->offsetsOfRoute(route);
+                scanRoute(route, stopIndex, tripSize, previousArrivalTimes, [&](const size_t trip, const StopIndex i) {
+                    return tripBases[trip] + offsets[(trip * tripSize) + i].departure;
+                }, [&](const size_t trip, const StopIndex i) {
+                    return tripBases[trip] + offsets[(trip * tripSize) + i].arrival;
+                });
+            } else {
+                const StopEvent* stopEvents = data.firstTripOfRoute(route);
+                scanRoute(route, stopIndex, tripSize, previousArrivalTimes, [&](const size_t trip, const StopIndex i) {
+                    return stopEvents[(trip * tripSize) + i].departureTime;
+                }, [&](const size_t trip, const StopIndex i) {
+                    return stopEvents[(trip * tripSize) + i].arrivalTime;
+                });
+            }
+        }
+        debugger.stopScanRoutes();
+    }
 
-            const StopId* stops = data.stopArrayOfRoute(route);
-            const StopEvent* trip = data.lastTripOfRoute(route);
-            StopId stop = stops[stopIndex];
-            AssertMsg(trip[stopIndex].departureTime >= previousRound()[stop].arrivalTime, "Cannot scan a route after the last trip has departed (Route: " << route << ", Stop: " << stop << ", StopIndex: " << stopIndex << ", Time: " << previousRound()[stop].arrivalTime << ", LastDeparture: " << trip[stopIndex].departureTime << ")!");
-
-            StopIndex parentIndex = stopIndex;
-            const StopEvent* firstTrip = data.firstTripOfRoute(route);
-            while (stopIndex < tripSize - 1) {
-                while ((trip > firstTrip) && ((trip - tripSize + stopIndex)->departureTime >= previousRound()[stop].arrivalTime)) {
-                    trip -= tripSize;
+    // Scans the route from stopIndex on, departureTime(trip, i) and arrivalTime(trip, i) are the times of the i-th stop
+    // event of the trip (trips are numbered from 0, by increasing departure time).
+    template<typename DEPARTURE_TIME, typename ARRIVAL_TIME>
+    inline void scanRoute(const RouteId route, StopIndex stopIndex, const size_t tripSize, const int* previousArrivalTimes, const DEPARTURE_TIME& departureTime, const ARRIVAL_TIME& arrivalTime) noexcept {
+        const StopId* stops = data.stopArrayOfRoute(route);
+        size_t trip = data.numberOfTripsInRoute(route) - 1;
+        StopId stop = stops[stopIndex];
+        AssertMsg(departureTime(trip, stopIndex) >= previousArrivalTimes[stop], "Cannot scan a route after the last trip has departed (Route: " << route << ", Stop: " << stop << ", StopIndex: " << stopIndex << ", Time: " << previousArrivalTimes[stop] << ", LastDeparture: " << departureTime(trip, stopIndex) << ")!");
+
+        const bool useDepartureColumns = departureColumns && departureColumns->hasColumns(route);
+        StopIndex parentIndex = stopIndex;
+        while (stopIndex < tripSize - 1) {
+            if (useDepartureColumns) {
+                const size_t earliestTrip = departureColumns->earliestTrip(route, stopIndex, previousArrivalTimes[stop], trip);
+                if (earliestTrip < trip) {
+                    trip = earliestTrip;
                     parentIndex = stopIndex;
                 }
-                stopIndex++;
-                stop = stops[stopIndex];
-                debugger.scanRouteSegment(data.getRouteSegmentNum(route, stopIndex));
-                if (arrivalByRoute(stop, trip[stopIndex].arrivalTime)) {
-                    myserver::EarliestArrivalLabel& label = currentRound()[stop];
-                    label.parent = stops[parentIndex];
-                    label.parentDepartureTime = trip[parentIndex].departureTime;
-                    label.usesRoute = true;
-                    label.routeId = route;
+            } else {
+                while ((trip > 0) && (departureTime(trip - 1, stopIndex) >= previousArrivalTimes[stop])) {
+                    trip--;
+                    parentIndex = stopIndex;
                 }
             }
+            stopIndex++;
+            stop = stops[stopIndex];
+            debugger.scanRouteSegment(data.getRouteSegmentNum(route, stopIndex));
+            if (arrivalByRoute(stop, arrivalTime(trip, stopIndex))) {
+                myserver::ParentLabel& label = rounds.current_parent(stop);
+                label.parent = stops[parentIndex];
+                label.parentDepartureTime = departureTime(trip, parentIndex);
+                label.usesRoute = true;
+                label.routeId = route;
+            }
         }
-        debugger.stopScanRoutes();
     }
 
-    inline void relaxInitialTransfers(const int sourceDepartureTime) noexcept {
-        debugger.startRelaxTransfers();
-        initialTransfers.run(sourceVertex, targetVertex);
+    inline void computeInitialTransfers() noexcept {
+        debugger.startInitialTransfers();
+        if (!sourceStops.empty()) {
+            initialTransfers.clear();
+            for (const AccessStop& access : sourceStops) {
+                initialTransfers.addSource(access.stop, access.walkingTime);
+            }
+            for (const AccessStop& access : targetStops) {
+                initialTransfers.addTarget(access.stop, access.walkingTime);
+            }
+            initialTransfers.run();
+        } else if (targetVertex == noVertex) {
+            initialTransfers.template run<FORWARD, BACKWARD>(sourceVertex);
+        } else {
+            initialTransfers.run(sourceVertex, targetVertex);
+        }
         debugger.directWalking(initialTransfers.getDistance());
+        debugger.stopInitialTransfers();
+    }
+
+    inline void relaxInitialTransfers(const int sourceDepartureTime) noexcept {
+        debugger.startInitialTransfers();
         for (const Vertex stop : initialTransfers.getForwardPOIs()) {
             if (stop == targetStop) continue;
             AssertMsg(data.isStop(stop), "Reached POI " << stop << " is not a stop!");
@@ -201,8 +599,8 @@ private:
             const int arrivalTime = sourceDepartureTime + initialTransfers.getForwardDistance(stop);
             if (arrivalByTransfer(StopId(stop), arrivalTime)) {
                 debugger.updateStopByTransfer(StopId(stop), arrivalTime);
-                myserver::EarliestArrivalLabel& label = currentRound()[stop];
-                label.parent = sourceVertex;
+                myserver::ParentLabel& label = rounds.current_parent(stop);
+                label.parent = sourceOf(stop);
                 label.parentDepartureTime = sourceDepartureTime;
                 label.usesRoute = false;
                 label.transferId = noEdge;
@@ -212,31 +610,33 @@ private:
             const int arrivalTime = sourceDepartureTime + initialTransfers.getDistance();
             if (arrivalByTransfer(targetStop, arrivalTime)) {
                 debugger.updateStopByTransfer(targetStop, arrivalTime);
-                myserver::EarliestArrivalLabel& label = currentRound()[targetStop];
-                label.parent = sourceVertex;
+                myserver::ParentLabel& label = rounds.current_parent(targetStop);
+                label.parent = sourceOfDirectWalk();
                 label.parentDepartureTime = sourceDepartureTime;
                 label.usesRoute = false;
                 label.transferId = noEdge;
             }
         }
-        debugger.stopRelaxTransfers();
+        debugger.stopInitialTransfers();
     }
 
     inline void relaxIntermediateTransfers() noexcept {
         debugger.startRelaxTransfers();
         stopsUpdatedByTransfer.clear();
         routesServingUpdatedStops.clear();
+        const int* currentArrivalTimes = currentRound();
+        const TransferGraph& graph = *shortcutGraph;
         for (const StopId stop : stopsUpdatedByRoute) {
-            const int earliestArrivalTime = currentRound()[stop].arrivalTime;
-            for (const Edge edge : data.transferGraph.edgesFrom(stop)) {
-                const StopId toStop = StopId(data.transferGraph.get(ToVertex, edge));
+            const int earliestArrivalTime = currentArrivalTimes[stop];
+            for (const Edge edge : graph.edgesFrom(stop)) {
+                const StopId toStop = StopId(graph.get(ToVertex, edge));
                 if (toStop == targetStop) continue;
                 debugger.relaxEdge(edge);
-                const int arrivalTime = earliestArrivalTime + data.transferGraph.get(TravelTime, edge);
-                AssertMsg(data.isStop(data.transferGraph.get(ToVertex, edge)), "Graph contains edges to non stop vertices!");
+                const int arrivalTime = earliestArrivalTime + graph.get(TravelTime, edge);
+                AssertMsg(data.isStop(graph.get(ToVertex, edge)), "Graph contains edges to non stop vertices!");
                 if (arrivalByTransfer(toStop, arrivalTime)) {
                     debugger.updateStopByTransfer(toStop, arrivalTime);
-                    myserver::EarliestArrivalLabel& label = currentRound()[toStop];
+                    myserver::ParentLabel& label = rounds.current_parent(toStop);
                     label.parent = stop;
                     label.parentDepartureTime = earliestArrivalTime;
                     label.usesRoute = false;
@@ -247,7 +647,7 @@ private:
                 const int arrivalTime = earliestArrivalTime + initialTransfers.getBackwardDistance(stop);
                 if (arrivalByTransfer(targetStop, arrivalTime)) {
                     debugger.updateStopByTransfer(targetStop, arrivalTime);
-                    myserver::EarliestArrivalLabel& label = currentRound()[targetStop];
+                    myserver::ParentLabel& label = rounds.current_parent(targetStop);
                     label.parent = stop;
                     label.parentDepartureTime = earliestArrivalTime;
                     label.usesRoute = false;
@@ -260,49 +660,63 @@ private:
         debugger.stopRelaxTransfers();
     }
 
-    inline myserver::Round& currentRound() noexcept {
+    inline const int* currentRound() const noexcept {
         AssertMsg(!rounds.empty(), "Cannot return current round, because no round exists!");
-        return rounds.back();
+        return rounds.arrival_times_of_round(rounds.size() - 1);
     }
 
-    inline myserver::Round& previousRound() noexcept {
+    inline const int* previousRound() const noexcept {
         AssertMsg(rounds.size() >= 2, "Cannot return previous round, because less than two rounds exist!");
-        return rounds[rounds.size() - 2];
+        return rounds.arrival_times_of_round(rounds.size() - 2);
     }
 
     inline void startNewRound() noexcept {
-        rounds.emplace_back(data.numberOfStops() + 1);
+        rounds.start_new_round();
     }
 
     inline bool arrivalByRoute(const StopId stop, const int time) noexcept {
         AssertMsg(data.isStop(stop), "Stop " << stop << " is out of range!");
-        if (earliestArrival[targetStop] <= time) return false;
-        if (earliestArrival[stop] <= time) return false;
+        if (rounds.earliest_arrival_time(targetStop) <= time) return false;
+        if (rounds.earliest_arrival_time(stop) <= time) return false;
+        if (rounds.current_arrival_time(targetStop) <= time) return false;
+        if (rounds.current_arrival_time(stop) <= time) return false;
         debugger.updateStopByRoute(stop, time);
-        currentRound()[stop].arrivalTime = time;
-        earliestArrival[stop] = time;
+        rounds.update_arrival_time(stop, time);
         stopsUpdatedByRoute.insert(stop);
         return true;
     }
 
     inline bool arrivalByTransfer(const StopId stop, const int time) noexcept {
         AssertMsg(data.isStop(stop) || stop == targetStop, "Stop " << stop << " is out of range!");
-        if (earliestArrival[targetStop] <= time) return false;
-        if (earliestArrival[stop] <= time) return false;
-        currentRound()[stop].arrivalTime = time;
-        earliestArrival[stop] = time;
+        if (rounds.earliest_arrival_time(targetStop) <= time) return false;
+        if (rounds.earliest_arrival_time(stop) <= time) return false;
+        if (rounds.current_arrival_time(targetStop) <= time) return false;
+        if (rounds.current_arrival_time(stop) <= time) return false;
+        rounds.update_arrival_time(stop, time);
         if (data.isStop(stop)) stopsUpdatedByTransfer.insert(stop);
         return true;
     }
 
 private:
     const Data& data;
+    const size_t numberOfVertices;
 
-    BucketCHInitialTransfers initialTransfers;
+    // The shortcuts relaxed by the current query: those of data, or those of the window of its departure time (which are
+    // exact up to shortcutGraphValidUntil) :
+    std::shared_ptr<const ShortcutWindows> shortcutWindows;
+    const TransferGraph* shortcutGraph;
+    int shortcutGraphValidUntil;
+
+    // If set, the routes are scanned using these instead of the stop events of data:
+    std::shared_ptr<const CompactStopEvents> compactStopEvents;
 
-    std::vector<myserver::Round> rounds;
+    // If set, the earliest trips of the routes having columns are searched in these:
+    std::shared_ptr<const DepartureColumns> departureColumns;
 
-    std::vector<int> earliestArrival;
+    BucketCHInitialTransfers initialTransfers;
+    CH::PHAST<CHGraph> finalTransfers;
+
+    myserver::RoundLabels rounds;
 
     IndexedSet<false, StopId> stopsUpdatedByRoute;
     IndexedSet<false, StopId> stopsUpdatedByTransfer;
@@ -312,6 +726,10 @@ private:
     Vertex targetVertex;
     StopId targetStop;
 
+    // Queries between locations begin and end at several stops :
+    std::vector<AccessStop> sourceStops;
+    std::vector<AccessStop> targetStops;
+
     Debugger debugger;
 
 };
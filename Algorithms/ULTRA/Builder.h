@@ -21,66 +21,196 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <vector>
 
 #include "../../DataStructures/RAPTOR/Data.h"
+#include "../../DataStructures/RAPTOR/Stations.h"
+#include "../../DataStructures/RAPTOR/StopDepartures.h"
 #include "../../Helpers/MultiThreading.h"
 #include "../../Helpers/Timer.h"
 #include "../../Helpers/Console/Progress.h"
+#include "../../Helpers/IO/Serialization.h"
+#include "../../Helpers/FileSystem/FileSystem.h"
+#include "../../Helpers/String/String.h"
 
 #include "RangeSearchUsingStations.h"
+#include "ShortcutDependencies.h"
 
 namespace ULTRA {
 
-template<bool DEBUG = false, bool REQUIRE_DIRECT_TRANSFER = false>
+// If USE_RADIX_HEAP is set, the transfer searches of the range searches use a radix heap instead of a binary heap
+// (see ExternalRadixHeap).
+template<bool DEBUG = false, bool REQUIRE_DIRECT_TRANSFER = false, bool USE_RADIX_HEAP = false>
 class Builder {
 
 public:
     inline static constexpr bool Debug = DEBUG;
     inline static constexpr bool RequireDirectTransfer = REQUIRE_DIRECT_TRANSFER;
-    using Type = Builder<Debug, RequireDirectTransfer>;
+    inline static constexpr bool UseRadixHeap = USE_RADIX_HEAP;
+    using Type = Builder<Debug, RequireDirectTransfer, UseRadixHeap>;
+    using Shortcut = ShortcutDependencies::Shortcut;
 
 public:
     Builder(const RAPTOR::Data& data) :
-        data(data) {
+        data(data),
+        checkpointInterval(0),
+        resumeFromCheckpoint(false) {
         shortcutGraph.addVertices(data.numberOfStops());
         for (const Vertex vertex : shortcutGraph.vertices()) {
             shortcutGraph.set(Coordinates, vertex, data.transferGraph.get(Coordinates, vertex));
         }
     }
 
-    void computeShortcuts(const ThreadPinning& threadPinning, const int witnessTransferLimit = 15 * 60, const int minDepartureTime = -never, const int maxDepartureTime = never, const bool verbose = true) noexcept {
+    // Stations with more than maxDeparturesPerTask departures (typically a few hubs) are not searched by a single thread:
+    // their departures are split into slices of maxDeparturesPerTask departures, which are searched in parallel once all
+    // other stations are done. This avoids a long tail at the end of the computation, but the slices may add a few
+    // shortcuts (see RangeSearchUsingStations::run).
+    void computeShortcuts(const ThreadPinning& threadPinning, const int witnessTransferLimit = 15 * 60, const int minDepartureTime = -never, const int maxDepartureTime = never, const bool verbose = true, const size_t maxDeparturesPerTask = std::numeric_limits<size_t>::max()) noexcept {
+        using RangeSearch = RangeSearchUsingStations<Debug, RequireDirectTransfer, UseRadixHeap>;
+        using DepartureList = std::vector<typename RangeSearch::ConsolidatedDepartureLabel>;
+        AssertMsg(maxDeparturesPerTask > 0, "The departures of a station cannot be split into slices of 0 departures!");
         if (verbose) std::cout << "Computing shortcuts with " << threadPinning.numberOfThreads << " threads." << std::endl;
+        computeStations(threadPinning, verbose);
+        computeStopDepartures(verbose);
 
-        Progress progress(data.numberOfStops(), verbose);
+        // The shortcuts of the stations that were completed before the last interruption are one more list to merge :
+        std::vector<bool> completed(data.numberOfStops(), false);
+        std::vector<Shortcut> resumedShortcuts;
+        if (resumeFromCheckpoint) readCheckpoint(witnessTransferLimit, minDepartureTime, maxDepartureTime, completed, resumedShortcuts, verbose);
+        std::vector<StopId> sources;
+        for (const StopId stop : data.stops()) {
+            if (!completed[stop]) sources.emplace_back(stop);
+        }
+        std::vector<uint8_t> sourceCompleted(sources.size(), false);
+        const size_t batchSize = checkpointFileName.empty() ? sources.size() : 64 * threadPinning.numberOfThreads;
+        bool writeCheckpoint = false;
+        Timer checkpointTimer;
+
+        // Every thread collects the shortcuts it found in its own (sorted) list, the lists are merged afterwards :
+        std::vector<std::vector<Shortcut>> shortcutsOfThread(threadPinning.numberOfThreads);
+        std::vector<std::vector<std::pair<StopId, DepartureList>>> hubsOfThread(threadPinning.numberOfThreads);
+        std::vector<HubSlice> slices;
+        Progress progress(sources.size(), verbose);
         omp_set_num_threads(threadPinning.numberOfThreads);
         #pragma omp parallel
         {
             threadPinning.pinThread();
 
-            DynamicTransferGraph localShortcutGraph = shortcutGraph;
-            RangeSearchUsingStations<Debug, RequireDirectTransfer> rangeSearch(data, localShortcutGraph, witnessTransferLimit);
+            DynamicTransferGraph localShortcutGraph;
+            localShortcutGraph.addVertices(data.numberOfStops());
+            RangeSearch rangeSearch(data, localShortcutGraph, stations, stopDepartures, witnessTransferLimit);
+            std::vector<std::pair<StopId, DepartureList>>& hubs = hubsOfThread[omp_get_thread_num()];
 
-            #pragma omp for schedule(dynamic)
-            for (size_t i = 0; i < data.numberOfStops(); i++) {
-                rangeSearch.run(StopId(i), minDepartureTime, maxDepartureTime);
-                progress++;
+            for (size_t batchBegin = 0; batchBegin < sources.size(); batchBegin += batchSize) {
+                const size_t batchEnd = std::min(batchBegin + batchSize, sources.size());
+                #pragma omp for schedule(dynamic)
+                for (size_t i = batchBegin; i < batchEnd; i++) {
+                    if (maxDeparturesPerTask == std::numeric_limits<size_t>::max()) {
+                        rangeSearch.run(sources[i], minDepartureTime, maxDepartureTime);
+                        sourceCompleted[i] = true;
+                    } else {
+                        DepartureList departures = rangeSearch.getDepartures(sources[i], minDepartureTime, maxDepartureTime);
+                        if (departures.size() > maxDeparturesPerTask) {
+                            hubs.emplace_back(sources[i], std::move(departures));
+                        } else {
+                            rangeSearch.run(sources[i], departures, 0, departures.size());
+                            sourceCompleted[i] = true;
+                        }
+                    }
+                    progress++;
+                }
+                if (checkpointFileName.empty()) continue;
+
+                #pragma omp single
+                writeCheckpoint = (batchEnd < sources.size()) && (checkpointTimer.elapsedMilliseconds() >= 1000.0 * checkpointInterval);
+                if (!writeCheckpoint) continue;
+                collectShortcuts(localShortcutGraph, shortcutsOfThread[omp_get_thread_num()]);
+                #pragma omp barrier
+                #pragma omp single
+                {
+                    std::vector<std::vector<Shortcut>> lists = shortcutsOfThread;
+                    lists.emplace_back(resumedShortcuts);
+                    std::vector<bool> completedSoFar = completed;
+                    for (size_t i = 0; i < batchEnd; i++) {
+                        if (sourceCompleted[i]) completedSoFar[sources[i]] = true;
+                    }
+                    writeCheckpointFile(witnessTransferLimit, minDepartureTime, maxDepartureTime, completedSoFar, mergeShortcuts(lists));
+                    checkpointTimer.restart();
+                }
             }
 
-            #pragma omp critical
+            #pragma omp single
             {
-                for (const Vertex from : shortcutGraph.vertices()) {
-                    for (const Edge edge : localShortcutGraph.edgesFrom(from)) {
-                        const Vertex to = localShortcutGraph.get(ToVertex, edge);
-                        if (!shortcutGraph.hasEdge(from, to)) {
-                            shortcutGraph.addEdge(from, to).set(TravelTime, localShortcutGraph.get(TravelTime, edge));
-                        } else {
-                            AssertMsg(shortcutGraph.get(TravelTime, shortcutGraph.findEdge(from, to)) == localShortcutGraph.get(TravelTime, edge), "Edge from " << from << " to " << to << " has inconclusive travel time (" << shortcutGraph.get(TravelTime, shortcutGraph.findEdge(from, to)) << ", " << localShortcutGraph.get(TravelTime, edge) << ")");
+                for (size_t thread = 0; thread < hubsOfThread.size(); thread++) {
+                    for (size_t hub = 0; hub < hubsOfThread[thread].size(); hub++) {
+                        const size_t numberOfDepartures = hubsOfThread[thread][hub].second.size();
+                        for (size_t begin = 0; begin < numberOfDepartures; begin += maxDeparturesPerTask) {
+                            slices.emplace_back(HubSlice{thread, hub, begin, std::min(begin + maxDeparturesPerTask, numberOfDepartures)});
                         }
                     }
                 }
+                if (verbose && !slices.empty()) std::cout << std::endl << "Splitting the departures of hub stations into " << String::prettyInt(slices.size()) << " slices." << std::endl;
             }
+
+            #pragma omp for schedule(dynamic)
+            for (size_t i = 0; i < slices.size(); i++) {
+                const std::pair<StopId, DepartureList>& hub = hubsOfThread[slices[i].thread][slices[i].hub];
+                rangeSearch.run(hub.first, hub.second, slices[i].begin, slices[i].end);
+            }
+
+            collectShortcuts(localShortcutGraph, shortcutsOfThread[omp_get_thread_num()]);
         }
         if (verbose) std::cout << std::endl;
+        shortcutsOfThread.emplace_back(std::move(resumedShortcuts));
+        buildShortcutGraph(mergeShortcuts(shortcutsOfThread));
+    }
+
+    // computeShortcuts (the variant without dependencies) writes the completed stations and their shortcuts to fileName
+    // whenever intervalInSeconds have passed since the last checkpoint. If resume is set, the stations that were
+    // completed according to an existing checkpoint file are not searched again.
+    inline void useCheckpoint(const std::string& fileName, const int intervalInSeconds, const bool resume) noexcept {
+        checkpointFileName = fileName;
+        checkpointInterval = intervalInSeconds;
+        resumeFromCheckpoint = resume;
+    }
+
+    // Same as above, but the shortcuts of every source station are computed independently of the other stations, and are
+    // recorded in dependencies, together with the parts of the timetable they depend on. This is slower (shortcuts found
+    // by other stations cannot be used for pruning), but allows updating the shortcuts incrementally with updateShortcuts.
+    void computeShortcuts(const ThreadPinning& threadPinning, ShortcutDependencies& dependencies, const int witnessTransferLimit = 15 * 60, const int minDepartureTime = -never, const int maxDepartureTime = never, const bool verbose = true) noexcept {
+        dependencies = ShortcutDependencies(data.numberOfStops(), data.numberOfRoutes(), witnessTransferLimit, minDepartureTime, maxDepartureTime, RequireDirectTransfer);
+        std::vector<StopId> sources;
+        for (const StopId stop : data.stops()) {
+            sources.emplace_back(stop);
+        }
+        if (verbose) std::cout << "Computing shortcuts (and their dependencies) with " << threadPinning.numberOfThreads << " threads." << std::endl;
+        computeShortcutsOfSources(threadPinning, sources, dependencies, verbose);
+        buildShortcutGraph(dependencies);
+    }
+
+    // Updates the shortcuts recorded in dependencies (by one of the computeShortcuts above, for a previous version of the
+    // timetable) to the current timetable, by searching again from the source stations that can be affected by the changed
+    // routes. Returns the number of source stations that were searched again.
+    size_t updateShortcuts(const ThreadPinning& threadPinning, ShortcutDependencies& dependencies, const std::vector<RouteId>& changedRoutes, const bool verbose = true) noexcept {
+        Ensure(dependencies.requireDirectTransfer == RequireDirectTransfer, "The shortcuts were computed with a different direct transfer requirement!");
+        const std::vector<StopId> sources = dependencies.getAffectedSources(data, changedRoutes);
+        dependencies.numberOfRoutes = data.numberOfRoutes();
+        if (verbose) std::cout << "Updating the shortcuts of " << String::prettyInt(sources.size()) << " / " << String::prettyInt(data.numberOfStops()) << " stops with " << threadPinning.numberOfThreads << " threads." << std::endl;
+        computeShortcutsOfSources(threadPinning, sources, dependencies, verbose);
+        buildShortcutGraph(dependencies);
+        return sources.size();
+    }
+
+    // The stations (see RAPTOR::Stations) are shared by the range searches of all threads. If none are given, they are
+    // computed (in parallel) before the first search.
+    inline void useStations(const std::shared_ptr<const RAPTOR::Stations>& sharedStations) noexcept {
+        Ensure(sharedStations && sharedStations->isStationsOf(data), "The stations were computed for another network!");
+        stations = sharedStations;
     }
 
     inline const DynamicTransferGraph& getShortcutGraph() const noexcept {
@@ -91,9 +221,150 @@ public:
         return shortcutGraph;
     }
 
+private:
+    // A slice [begin, end) of the departures of a hub station, the station is identified by its index in hubsOfThread :
+    struct HubSlice {
+        size_t thread;
+        size_t hub;
+        size_t begin;
+        size_t end;
+    };
+
+    inline void computeShortcutsOfSources(const ThreadPinning& threadPinning, const std::vector<StopId>& sources, ShortcutDependencies& dependencies, const bool verbose) noexcept {
+        computeStations(threadPinning, verbose);
+        computeStopDepartures(verbose);
+        Progress progress(sources.size(), verbose);
+        omp_set_num_threads(threadPinning.numberOfThreads);
+        #pragma omp parallel
+        {
+            threadPinning.pinThread();
+
+            DynamicTransferGraph sourceShortcutGraph;
+            sourceShortcutGraph.addVertices(data.numberOfStops());
+            RangeSearchUsingStations<Debug, RequireDirectTransfer, UseRadixHeap> rangeSearch(data, sourceShortcutGraph, stations, stopDepartures, dependencies.witnessTransferLimit);
+
+            #pragma omp for schedule(dynamic)
+            for (size_t i = 0; i < sources.size(); i++) {
+                ShortcutDependencies::Source& source = dependencies[sources[i]];
+                rangeSearch.run(sources[i], dependencies.minDepartureTime, dependencies.maxDepartureTime, source.routes, source.stops);
+                source.shortcuts.clear();
+                for (const Vertex from : sourceShortcutGraph.vertices()) {
+                    for (const Edge edge : sourceShortcutGraph.edgesFrom(from)) {
+                        source.shortcuts.emplace_back(StopId(from), StopId(sourceShortcutGraph.get(ToVertex, edge)), sourceShortcutGraph.get(TravelTime, edge));
+                    }
+                }
+                if (!source.shortcuts.empty()) {
+                    sourceShortcutGraph.clear();
+                    sourceShortcutGraph.addVertices(data.numberOfStops());
+                }
+                progress++;
+            }
+        }
+        if (verbose) std::cout << std::endl;
+    }
+
+    inline void computeStations(const ThreadPinning& threadPinning, const bool verbose) noexcept {
+        if (stations) return;
+        Timer timer;
+        stations = std::make_shared<const RAPTOR::Stations>(data, threadPinning);
+        if (verbose) std::cout << "Computed stations in " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
+    }
+
+    inline void computeStopDepartures(const bool verbose) noexcept {
+        if (stopDepartures) return;
+        Timer timer;
+        stopDepartures = std::make_shared<const RAPTOR::StopDepartures>(data);
+        if (verbose) std::cout << "Computed stop departures in " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
+    }
+
+    inline static void collectShortcuts(const DynamicTransferGraph& localShortcutGraph, std::vector<Shortcut>& shortcuts) noexcept {
+        shortcuts.clear();
+        shortcuts.reserve(localShortcutGraph.numEdges());
+        for (const Vertex from : localShortcutGraph.vertices()) {
+            for (const Edge edge : localShortcutGraph.edgesFrom(from)) {
+                shortcuts.emplace_back(StopId(from), StopId(localShortcutGraph.get(ToVertex, edge)), localShortcutGraph.get(TravelTime, edge));
+            }
+        }
+        sort(shortcuts);
+    }
+
+    // The checkpoint is first written to a temporary file, so that an interruption while writing keeps the previous one.
+    inline void writeCheckpointFile(const int witnessTransferLimit, const int minDepartureTime, const int maxDepartureTime, const std::vector<bool>& completed, const std::vector<Shortcut>& shortcuts) const noexcept {
+        const std::string temporaryFileName = checkpointFileName + ".tmp";
+        IO::serialize(temporaryFileName, data.numberOfStops(), witnessTransferLimit, minDepartureTime, maxDepartureTime, RequireDirectTransfer, completed, shortcuts);
+        Ensure(std::rename(temporaryFileName.c_str(), checkpointFileName.c_str()) == 0, "Cannot write checkpoint " << checkpointFileName << "!");
+    }
+
+    inline void readCheckpoint(const int witnessTransferLimit, const int minDepartureTime, const int maxDepartureTime, std::vector<bool>& completed, std::vector<Shortcut>& shortcuts, const bool verbose) const noexcept {
+        if (!FileSystem::isFile(checkpointFileName)) {
+            if (verbose) std::cout << "No checkpoint found in " << checkpointFileName << ", starting from scratch." << std::endl;
+            return;
+        }
+        size_t numberOfStops = 0;
+        int checkpointWitnessTransferLimit = 0;
+        int checkpointMinDepartureTime = 0;
+        int checkpointMaxDepartureTime = 0;
+        bool checkpointRequireDirectTransfer = false;
+        IO::deserialize(checkpointFileName, numberOfStops, checkpointWitnessTransferLimit, checkpointMinDepartureTime, checkpointMaxDepartureTime, checkpointRequireDirectTransfer, completed, shortcuts);
+        Ensure(numberOfStops == data.numberOfStops() && completed.size() == data.numberOfStops(), "Checkpoint " << checkpointFileName << " was written for another network!");
+        Ensure(checkpointWitnessTransferLimit == witnessTransferLimit && checkpointMinDepartureTime == minDepartureTime && checkpointMaxDepartureTime == maxDepartureTime && checkpointRequireDirectTransfer == RequireDirectTransfer, "Checkpoint " << checkpointFileName << " was written with other parameters!");
+        if (verbose) std::cout << "Resuming from " << checkpointFileName << ": " << String::prettyInt(Vector::count(completed, true)) << " stops and " << String::prettyInt(shortcuts.size()) << " shortcuts are done." << std::endl;
+    }
+
+    inline void buildShortcutGraph(const ShortcutDependencies& dependencies) noexcept {
+        std::vector<Shortcut> shortcuts;
+        shortcuts.reserve(dependencies.numberOfShortcuts());
+        for (const StopId stop : data.stops()) {
+            shortcuts.insert(shortcuts.end(), dependencies[stop].shortcuts.begin(), dependencies[stop].shortcuts.end());
+        }
+        sort(shortcuts);
+        std::vector<std::vector<Shortcut>> lists(1, std::move(shortcuts));
+        buildShortcutGraph(mergeShortcuts(lists));
+    }
+
+    // Merges sorted lists of shortcuts (pairwise, the merges of one level run in parallel) and removes the duplicates.
+    inline static std::vector<Shortcut> mergeShortcuts(std::vector<std::vector<Shortcut>>& lists) noexcept {
+        if (lists.empty()) return std::vector<Shortcut>();
+        for (size_t width = 1; width < lists.size(); width *= 2) {
+            #pragma omp parallel for schedule(dynamic)
+            for (size_t i = 0; i < lists.size() - width; i += 2 * width) {
+                std::vector<Shortcut> merged;
+                merged.reserve(lists[i].size() + lists[i + width].size());
+                std::merge(lists[i].begin(), lists[i].end(), lists[i + width].begin(), lists[i + width].end(), std::back_inserter(merged));
+                lists[i].swap(merged);
+                std::vector<Shortcut>().swap(lists[i + width]);
+            }
+        }
+        std::vector<Shortcut>& shortcuts = lists[0];
+        shortcuts.erase(std::unique(shortcuts.begin(), shortcuts.end(), [](const Shortcut& a, const Shortcut& b) {
+            AssertMsg((a.from != b.from) || (a.to != b.to) || (a.travelTime == b.travelTime), "Edge from " << a.from << " to " << a.to << " has inconclusive travel time (" << a.travelTime << ", " << b.travelTime << ")");
+            return (a.from == b.from) && (a.to == b.to);
+        }), shortcuts.end());
+        return std::move(shortcuts);
+    }
+
+    // The shortcuts are sorted and unique, hence they can be added without looking for existing edges.
+    inline void buildShortcutGraph(const std::vector<Shortcut>& shortcuts) noexcept {
+        shortcutGraph.clear();
+        shortcutGraph.addVertices(data.numberOfStops());
+        for (const Vertex vertex : shortcutGraph.vertices()) {
+            shortcutGraph.set(Coordinates, vertex, data.transferGraph.get(Coordinates, vertex));
+        }
+        shortcutGraph.reserve(data.numberOfStops(), shortcuts.size());
+        for (const Shortcut& shortcut : shortcuts) {
+            shortcutGraph.addEdge(shortcut.from, shortcut.to).set(TravelTime, shortcut.travelTime);
+        }
+    }
+
 private:
     const RAPTOR::Data& data;
     DynamicTransferGraph shortcutGraph;
+    std::shared_ptr<const RAPTOR::Stations> stations;
+    std::shared_ptr<const RAPTOR::StopDepartures> stopDepartures;
+
+    std::string checkpointFileName;
+    int checkpointInterval;
+    bool resumeFromCheckpoint;
 
 };
 
@@ -20,7 +20,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -32,17 +34,21 @@
 #include "../../DataStructures/Container/Map.h"
 #include "../../DataStructures/Container/Set.h"
 #include "../../DataStructures/Container/ExternalKHeap.h"
+#include "../../DataStructures/Container/ExternalRadixHeap.h"
 #include "../../DataStructures/RAPTOR/Data.h"
+#include "../../DataStructures/RAPTOR/Stations.h"
+#include "../../DataStructures/RAPTOR/StopDepartures.h"
 
 namespace ULTRA {
 
-template<bool DEBUG = false, bool REQUIRE_DIRECT_TRANSFER = false>
+template<bool DEBUG = false, bool REQUIRE_DIRECT_TRANSFER = false, bool USE_RADIX_HEAP = false>
 class RangeSearchUsingStations {
 
 public:
     inline static constexpr bool Debug = DEBUG;
     inline static constexpr bool RequireDirectTransfer = REQUIRE_DIRECT_TRANSFER;
-    using Type = RangeSearchUsingStations<Debug, RequireDirectTransfer>;
+    inline static constexpr bool UseRadixHeap = USE_RADIX_HEAP;
+    using Type = RangeSearchUsingStations<Debug, RequireDirectTransfer, UseRadixHeap>;
 
 public:
     struct ArrivalLabel : public ExternalKHeapElement {
@@ -51,7 +57,11 @@ public:
         inline bool hasSmallerKey(const ArrivalLabel* const other) const noexcept {
             return arrivalTime < other->arrivalTime;
         }
+        inline int getKey() const noexcept {
+            return arrivalTime;
+        }
     };
+    using Queue = Meta::IF<UseRadixHeap, ExternalRadixHeap<ArrivalLabel>, ExternalKHeap<2, ArrivalLabel>>;
 
     struct DepartureLabel {
         DepartureLabel(const RouteId routeId = noRouteId, const StopIndex stopIndex = noStopIndex, const int departureTime = never) : route(routeId, stopIndex), departureTime(departureTime) {}
@@ -72,24 +82,33 @@ public:
     };
 
     struct Station {
-        Station() : representative(noStop) {}
-        StopId representative;
-        std::vector<StopId> stops;
-        inline void add(const StopId stop) noexcept {
-            if (representative > stop) {
-                representative = stop;
-            }
-            stops.emplace_back(stop);
+        Station(const StopId representative = noStop, const SubRange<std::vector<StopId>>& stops = SubRange<std::vector<StopId>>()) :
+            representative(representative),
+            stops(stops) {
         }
+        StopId representative;
+        SubRange<std::vector<StopId>> stops;
     };
 
 public:
-    RangeSearchUsingStations(const RAPTOR::Data& data, DynamicTransferGraph& shortcutGraph, const int witnessTransferLimit) :
+    // The stations and the departures of the stops are only read, hence they can be shared by the searches of all threads
+    // (see RAPTOR::Stations and RAPTOR::StopDepartures).
+    RangeSearchUsingStations(const RAPTOR::Data& data, DynamicTransferGraph& shortcutGraph, const std::shared_ptr<const RAPTOR::Stations>& stations, const std::shared_ptr<const RAPTOR::StopDepartures>& stopDepartures, const int witnessTransferLimit) :
         data(data),
         shortcutGraph(shortcutGraph),
-        stationOfStop(data.numberOfStops()),
+        stations(stations),
+        stopDepartures(stopDepartures),
         sourceStation(),
+        labelsAreClean(false),
         sourceDepartureTime(0),
+        directTransferArrivalLabels(data.transferGraph.numVertices()),
+        zeroTripsArrivalLabels(data.numberOfStops()),
+        oneTripArrivalLabels(data.transferGraph.numVertices()),
+        twoTripsArrivalLabels(data.transferGraph.numVertices()),
+        oneTripTransferParent(data.transferGraph.numVertices(), noStop),
+        twoTripsRouteParent(data.numberOfStops(), noStop),
+        touchedVertices(data.transferGraph.numVertices()),
+        maxTouchedVertices(std::max<size_t>(data.transferGraph.numVertices() / 16, 1)),
         shortcutCandidatesInQueue(0),
         shortcutOriginCandidates(data.numberOfStops() + 1),
         shortcutDestinationCandidates(data.numberOfStops()),
@@ -97,43 +116,95 @@ public:
         stopsUpdatedByRoute(data.numberOfStops()),
         stopsUpdatedByTransfer(data.numberOfStops()),
         witnessTransferLimit(witnessTransferLimit),
-        earliestDepartureTime(data.getMinDepartureTime()) {
+        earliestDepartureTime(data.getMinDepartureTime()),
+        firstReachedStopIndex(data.numberOfRoutes()),
+        recordDependencies(false),
+        dependencyRoutes(data.numberOfRoutes()),
+        dependencyStops(data.numberOfStops()) {
         AssertMsg(data.hasImplicitBufferTimes(), "Shortcut search requires implicit departure buffer times!");
-        Dijkstra<TransferGraph, false> dijkstra(data.transferGraph);
-        for (const StopId stop : data.stops()) {
-            dijkstra.run(stop, noVertex, [&](const Vertex u) {
-                if (!data.isStop(u)) return;
-                stationOfStop[stop].add(StopId(u));
-            }, NoOperation, [&](const Vertex, const Edge edge) {
-                return data.transferGraph.get(TravelTime, edge) > 0;
-            });
-        }
+        AssertMsg(stations && stations->isStationsOf(data), "The stations were not computed for this data!");
+        AssertMsg(stopDepartures && stopDepartures->isDeparturesOf(data), "The stop departures were not computed for this data!");
+    }
+
+    RangeSearchUsingStations(const RAPTOR::Data& data, DynamicTransferGraph& shortcutGraph, const int witnessTransferLimit) :
+        RangeSearchUsingStations(data, shortcutGraph, std::make_shared<const RAPTOR::Stations>(data), std::make_shared<const RAPTOR::StopDepartures>(data), witnessTransferLimit) {
     }
 
     inline void run(const StopId source, const int minTime, const int maxTime) noexcept {
         AssertMsg(data.isStop(source), "source (" << source << ") is not a stop!");
-        if (stationOfStop[source].representative != source) return;
+        if (!stations->isRepresentative(source)) return;
         setSource(source);
         std::vector<ConsolidatedDepartureLabel> departures = collectDepartures(minTime, maxTime);
         for (const ConsolidatedDepartureLabel& label : departures) {
             runForDepartureTime(label);
-            for (const StopId shortcutDestination : getShortcutDestinationStops()) {
-                const StopId shortcutOrigin = getShortcutOriginStop(shortcutDestination);
-                if (!shortcutGraph.hasEdge(shortcutOrigin, shortcutDestination)) {
-                    shortcutGraph.addEdge(shortcutOrigin, shortcutDestination).set(TravelTime, getShortcutTravelTime(shortcutDestination));
-                } else {
-                    AssertMsg(shortcutGraph.get(TravelTime, shortcutGraph.findEdge(shortcutOrigin, shortcutDestination)) == getShortcutTravelTime(shortcutDestination), "Edge from " << shortcutOrigin << " to " << shortcutDestination << " has inconclusive travel time (" << shortcutGraph.get(TravelTime, shortcutGraph.findEdge(shortcutOrigin, shortcutDestination)) << ", " << getShortcutTravelTime(shortcutDestination) << ")");
-                }
+            addShortcuts();
+        }
+    }
+
+    // The departures (latest first) that run iterates over for the given source, empty if the source is not the
+    // representative of its station.
+    inline std::vector<ConsolidatedDepartureLabel> getDepartures(const StopId source, const int minTime, const int maxTime) noexcept {
+        AssertMsg(data.isStop(source), "source (" << source << ") is not a stop!");
+        if (!stations->isRepresentative(source)) return std::vector<ConsolidatedDepartureLabel>();
+        setSource(source);
+        return collectDepartures(minTime, maxTime);
+    }
+
+    // Runs the search from source for the departures [begin, end) of departures (as returned by getDepartures) only, so
+    // that the departures of a station can be split among several threads. The searches of a slice are not pruned by the
+    // later departures of the station, hence a slice may find some shortcuts that the search over all departures would
+    // have discarded (they are valid transfers nonetheless).
+    inline void run(const StopId source, const std::vector<ConsolidatedDepartureLabel>& departures, const size_t begin, const size_t end) noexcept {
+        AssertMsg(stations->isRepresentative(source), "Source " << source << " is not representative of its station!");
+        AssertMsg(begin <= end && end <= departures.size(), "Departures [" << begin << ", " << end << ") are out of range!");
+        if ((sourceStation.representative != source) || (!labelsAreClean)) setSource(source);
+        for (size_t i = begin; i < end; i++) {
+            runForDepartureTime(departures[i]);
+            addShortcuts();
+        }
+    }
+
+    // Same as run, but additionally reports the parts of the timetable the search depended on: the routes that improved
+    // an arrival time, and the stops at which a trip could be boarded (the stops of the source station, and the stops
+    // reached by the intermediate transfer). A timetable change that touches none of them cannot add shortcuts to this source.
+    inline void run(const StopId source, const int minTime, const int maxTime, std::vector<RouteId>& usedRoutes, std::vector<StopId>& boardingStops) noexcept {
+        recordDependencies = true;
+        dependencyRoutes.clear();
+        dependencyStops.clear();
+        run(source, minTime, maxTime);
+        recordDependencies = false;
+        if (stations->isRepresentative(source)) {
+            for (const StopId stop : stations->stopsOf(source)) {
+                dependencyStops.insert(stop);
             }
         }
+        usedRoutes = dependencyRoutes.getValues();
+        sort(usedRoutes);
+        boardingStops = dependencyStops.getValues();
+        sort(boardingStops);
     }
 
 private:
+    inline void addShortcuts() noexcept {
+        for (const StopId shortcutDestination : getShortcutDestinationStops()) {
+            const StopId shortcutOrigin = getShortcutOriginStop(shortcutDestination);
+            if (!shortcutGraph.hasEdge(shortcutOrigin, shortcutDestination)) {
+                shortcutGraph.addEdge(shortcutOrigin, shortcutDestination).set(TravelTime, getShortcutTravelTime(shortcutDestination));
+            } else {
+                AssertMsg(shortcutGraph.get(TravelTime, shortcutGraph.findEdge(shortcutOrigin, shortcutDestination)) == getShortcutTravelTime(shortcutDestination), "Edge from " << shortcutOrigin << " to " << shortcutDestination << " has inconclusive travel time (" << shortcutGraph.get(TravelTime, shortcutGraph.findEdge(shortcutOrigin, shortcutDestination)) << ", " << getShortcutTravelTime(shortcutDestination) << ")");
+            }
+        }
+    }
+
     inline void setSource(const StopId sourceStop) noexcept {
         AssertMsg(directTransferQueue.empty(), "Queue for round 0 is not empty!");
-        AssertMsg(stationOfStop[sourceStop].representative == sourceStop, "Source " << sourceStop << " is not representative of its station!");
+        AssertMsg(stations->isRepresentative(sourceStop), "Source " << sourceStop << " is not representative of its station!");
         clear();
-        sourceStation = stationOfStop[sourceStop];
+        labelsAreClean = true;
+        sourceStation = Station(sourceStop, stations->stopsOf(sourceStop));
+        for (const StopId stop : sourceStation.stops) {
+            touch(stop);
+        }
         dijkstra<-1>();
         sort(stopsReachedByDirectTransfer);
         if constexpr (Debug) std::cout << "   Source stop: " << sourceStop << std::endl;
@@ -143,6 +214,7 @@ private:
     inline void runForDepartureTime(const ConsolidatedDepartureLabel& label) noexcept {
         if constexpr (Debug) std::cout << "   Running search for departure time: " << label.departureTime << " (" << String::secToTime(label.departureTime) << ")" << std::endl;
 
+        labelsAreClean = false;
         shortcutCandidatesInQueue = 0;
         shortcutOriginCandidates.clear();
         shortcutDestinationCandidates.clear();
@@ -192,30 +264,68 @@ private:
         return oneTripArrivalLabels[destinationStop].arrivalTime - oneTripArrivalLabels[oneTripTransferParent[destinationStop]].arrivalTime;
     }
 
+    // A departure at a stop index of a route is only relevant if no earlier stop of the route can be reached by a shorter
+    // direct transfer. Hence the reached stops are visited by increasing transfer time, and firstReachedStopIndex holds the
+    // smallest stop index of every route at which a stop with a shorter transfer time was reached. The departures of a stop
+    // are found by a binary search in its sorted departures, the sorted lists of all stops are then merged.
     inline std::vector<ConsolidatedDepartureLabel> collectDepartures(const int minTime, const int maxTime) noexcept {
         AssertMsg(directTransferArrivalLabels[sourceStation.representative].arrivalTime == 0, "Direct transfer for source " << sourceStation.representative << " is incorrect!");
         const int cutoffTime = std::max(minTime, earliestDepartureTime);
+        std::vector<StopId> reachedStops(stopsReachedByDirectTransfer);
+        for (const StopId stop : sourceStation.stops) {
+            reachedStops.emplace_back(stop);
+        }
+        std::sort(reachedStops.begin(), reachedStops.end(), [&](const StopId a, const StopId b) {
+            return (directTransferArrivalLabels[a].arrivalTime < directTransferArrivalLabels[b].arrivalTime) || ((directTransferArrivalLabels[a].arrivalTime == directTransferArrivalLabels[b].arrivalTime) && (a < b));
+        });
         std::vector<DepartureLabel> departureLabels;
-        for (const RouteId route : data.routes()) {
-            const StopId* stops = data.stopArrayOfRoute(route);
-            const size_t tripSize = data.numberOfStopsInRoute(route);
-            int minimalTransferTime = never;
-            for (size_t stopIndex = 0; stopIndex + 1 < tripSize; stopIndex++) {
-                if (directTransferArrivalLabels[stops[stopIndex]].arrivalTime > minimalTransferTime) continue;
-                minimalTransferTime = directTransferArrivalLabels[stops[stopIndex]].arrivalTime;
-                for (const RAPTOR::StopEvent* trip = data.firstTripOfRoute(route); trip <= data.lastTripOfRoute(route); trip += tripSize) {
-                    const int departureTime = trip[stopIndex].departureTime - minimalTransferTime;
-                    if (departureTime < cutoffTime) continue;
-                    if (departureTime > maxTime) break;
-                    if (stationOfStop[stops[stopIndex]].representative == sourceStation.representative) {
-                        departureLabels.emplace_back(noRouteId, noStopIndex, departureTime);
-                    } else {
-                        departureLabels.emplace_back(route, StopIndex(stopIndex), departureTime);
+        std::vector<size_t> firstDepartureOfList(1, 0);
+        firstReachedStopIndex.clear();
+        for (size_t i = 0, j = 0; i < reachedStops.size(); i = j) {
+            const int transferTime = directTransferArrivalLabels[reachedStops[i]].arrivalTime;
+            for (; (j < reachedStops.size()) && (directTransferArrivalLabels[reachedStops[j]].arrivalTime == transferTime); j++) {
+                const StopId stop = reachedStops[j];
+                const bool isSourceStation = (stations->representativeOf(stop) == sourceStation.representative);
+                const RAPTOR::StopDepartures::Departure* first = std::lower_bound(stopDepartures->beginOf(stop), stopDepartures->endOf(stop), cutoffTime, [&](const RAPTOR::StopDepartures::Departure& departure, const int time) {
+                    return departure.departureTime - transferTime < time;
+                });
+                const RAPTOR::StopDepartures::Departure* last = first;
+                while ((last != stopDepartures->endOf(stop)) && (last->departureTime - transferTime <= maxTime)) last++;
+                // The list of a stop has to be sorted latest first, and by route for equal departure times:
+                while (last != first) {
+                    const RAPTOR::StopDepartures::Departure* sameTime = last - 1;
+                    while ((sameTime != first) && ((sameTime - 1)->departureTime == (last - 1)->departureTime)) sameTime--;
+                    for (const RAPTOR::StopDepartures::Departure* departure = sameTime; departure != last; departure++) {
+                        const RAPTOR::RouteSegment& route = departure->route;
+                        if (firstReachedStopIndex.contains(route.routeId) && (firstReachedStopIndex[route.routeId] < route.stopIndex)) continue;
+                        if (isSourceStation) {
+                            departureLabels.emplace_back(noRouteId, noStopIndex, departure->departureTime - transferTime);
+                        } else {
+                            departureLabels.emplace_back(route.routeId, route.stopIndex, departure->departureTime - transferTime);
+                        }
                     }
+                    last = sameTime;
+                }
+                if (departureLabels.size() > firstDepartureOfList.back()) firstDepartureOfList.emplace_back(departureLabels.size());
+            }
+            for (size_t k = i; k < j; k++) {
+                for (const RAPTOR::RouteSegment& route : data.routesContainingStop(reachedStops[k])) {
+                    if (firstReachedStopIndex.contains(route.routeId) && (firstReachedStopIndex[route.routeId] <= route.stopIndex)) continue;
+                    firstReachedStopIndex.insert(route.routeId, route.stopIndex);
                 }
             }
         }
-        sort(departureLabels);
+        while (firstDepartureOfList.size() > 2) {
+            std::vector<size_t> firstDepartureOfMergedList;
+            size_t list = 0;
+            for (; list + 2 < firstDepartureOfList.size(); list += 2) {
+                std::inplace_merge(departureLabels.begin() + firstDepartureOfList[list], departureLabels.begin() + firstDepartureOfList[list + 1], departureLabels.begin() + firstDepartureOfList[list + 2]);
+                firstDepartureOfMergedList.emplace_back(firstDepartureOfList[list]);
+            }
+            if (list + 1 < firstDepartureOfList.size()) firstDepartureOfMergedList.emplace_back(firstDepartureOfList[list]);
+            firstDepartureOfMergedList.emplace_back(departureLabels.size());
+            firstDepartureOfList = std::move(firstDepartureOfMergedList);
+        }
         std::vector<ConsolidatedDepartureLabel> result(1);
         for (const DepartureLabel& label : departureLabels) {
             if (label.route.routeId == noRouteId) {
@@ -234,19 +344,30 @@ private:
     inline void clear() noexcept {
         sourceStation = Station();
 
-        std::vector<ArrivalLabel>(data.transferGraph.numVertices()).swap(directTransferArrivalLabels);
-        stopsReachedByDirectTransfer.clear();
-
-        std::vector<ArrivalLabel>(data.numberOfStops()).swap(zeroTripsArrivalLabels);
-
+        // The queues point to the labels, hence they are cleared first. If the previous source reached only a few vertices,
+        // only their labels are reset, otherwise resetting all labels in one sweep is faster than visiting them one by one.
         oneTripQueue.clear();
-        std::vector<ArrivalLabel>(data.transferGraph.numVertices()).swap(oneTripArrivalLabels);
-
         twoTripsQueue.clear();
-        std::vector<ArrivalLabel>(data.transferGraph.numVertices()).swap(twoTripsArrivalLabels);
-
-        std::vector<StopId>(data.transferGraph.numVertices(), noStop).swap(oneTripTransferParent);
-        std::vector<StopId>(data.numberOfStops(), noStop).swap(twoTripsRouteParent);
+        if (touchedVertices.size() < maxTouchedVertices) {
+            for (const Vertex vertex : touchedVertices) {
+                directTransferArrivalLabels[vertex] = ArrivalLabel();
+                oneTripArrivalLabels[vertex] = ArrivalLabel();
+                twoTripsArrivalLabels[vertex] = ArrivalLabel();
+                oneTripTransferParent[vertex] = noStop;
+                if (!data.isStop(vertex)) continue;
+                zeroTripsArrivalLabels[vertex] = ArrivalLabel();
+                twoTripsRouteParent[vertex] = noStop;
+            }
+        } else {
+            Vector::fill(directTransferArrivalLabels, ArrivalLabel());
+            Vector::fill(zeroTripsArrivalLabels, ArrivalLabel());
+            Vector::fill(oneTripArrivalLabels, ArrivalLabel());
+            Vector::fill(twoTripsArrivalLabels, ArrivalLabel());
+            Vector::fill(oneTripTransferParent, noStop);
+            Vector::fill(twoTripsRouteParent, noStop);
+        }
+        touchedVertices.clear();
+        stopsReachedByDirectTransfer.clear();
 
         shortcutCandidatesInQueue = 0;
         shortcutOriginCandidates.clear();
@@ -274,6 +395,7 @@ private:
                 }
             }
         } else {
+            if (recordDependencies) dependencyStops.insert(stopsUpdatedByTransfer.getValues());
             for (const StopId stop : stopsUpdatedByTransfer) {
                 for (const RAPTOR::RouteSegment& route : data.routesContainingStop(stop)) {
                     AssertMsg(data.isRoute(route.routeId), "Route " << route.routeId << " is out of range!");
@@ -326,6 +448,7 @@ private:
                 const int newArrivalTime = tripIterator.arrivalTime();
                 if (newArrivalTime < arrivalTime<CURRENT>(tripIterator.stop())) {
                     arrivalByRoute<CURRENT>(tripIterator.stop(), newArrivalTime, tripIterator.stop(parentIndex));
+                    if (recordDependencies) dependencyRoutes.insert(route);
                 }
             }
         }
@@ -353,7 +476,7 @@ private:
     inline void dijkstra() noexcept {
         static_assert((ROUND == -1) | (ROUND == 1) | (ROUND == 2), "Invalid round!");
         std::vector<ArrivalLabel>& label = getLabel<ROUND>();
-        ExternalKHeap<2, ArrivalLabel>& queue = getQueue<ROUND>();
+        Queue& queue = getQueue<ROUND>();
 
         int transferLimit = intMax;
         if constexpr (ROUND == 2) {
@@ -417,7 +540,7 @@ private:
             }
             if (data.isStop(currentVertex)) {
                 if constexpr (ROUND == -1) {
-                    if (stationOfStop[currentVertex].representative != sourceStation.representative) {
+                    if (stations->representativeOf(StopId(currentVertex)) != sourceStation.representative) {
                         stopsReachedByDirectTransfer.emplace_back(StopId(currentVertex));
                     }
                 } if constexpr (ROUND == 1) {
@@ -479,8 +602,9 @@ private:
 
     template<int ROUND>
     inline void arrivalByRoute(const StopId stop, const int arrivalTime, const StopId parent) noexcept {
+        touch(stop);
         if constexpr (ROUND == 1) {
-            if (stationOfStop[parent].representative == sourceStation.representative) {
+            if (stations->representativeOf(parent) == sourceStation.representative) {
                 shortcutOriginCandidates.insert(stop);
             }
             oneTripArrivalLabels[stop].arrivalTime = arrivalTime;
@@ -509,12 +633,20 @@ private:
         stopsUpdatedByRoute.insert(stop);
     }
 
+    // Records that the labels of vertex may be changed. Once too many vertices are touched, they are not recorded anymore,
+    // since all labels are reset by clear anyway.
+    inline void touch(const Vertex vertex) noexcept {
+        if (touchedVertices.size() >= maxTouchedVertices) return;
+        touchedVertices.insert(vertex);
+    }
+
     inline bool shortcutAlreadyExists(const StopId parent) const noexcept {
         return shortcutGraph.hasEdge(oneTripTransferParent[parent], parent);
     }
 
     template<int ROUND>
     inline void arrivalByEdge(const Vertex vertex, const int arrivalTime, const Vertex parent) noexcept {
+        touch(vertex);
         if constexpr (ROUND == -1) {
             suppressUnusedParameterWarning(parent);
             directTransferArrivalLabels[vertex].arrivalTime = arrivalTime;
@@ -613,7 +745,7 @@ private:
     }
 
     template<int ROUND>
-    inline ExternalKHeap<2, ArrivalLabel>& getQueue() noexcept {
+    inline Queue& getQueue() noexcept {
         if constexpr (ROUND == -1) {
             return directTransferQueue;
         } else if constexpr (ROUND == 1) {
@@ -628,26 +760,32 @@ private:
 private:
     const RAPTOR::Data& data;
     DynamicTransferGraph& shortcutGraph;
-    std::vector<Station> stationOfStop;
+    std::shared_ptr<const RAPTOR::Stations> stations;
+    std::shared_ptr<const RAPTOR::StopDepartures> stopDepartures;
 
     Station sourceStation;
+    bool labelsAreClean;
     int sourceDepartureTime;
 
     std::vector<ArrivalLabel> directTransferArrivalLabels;
-    ExternalKHeap<2, ArrivalLabel> directTransferQueue;
+    Queue directTransferQueue;
     std::vector<StopId> stopsReachedByDirectTransfer;
 
     std::vector<ArrivalLabel> zeroTripsArrivalLabels;
 
     std::vector<ArrivalLabel> oneTripArrivalLabels;
-    ExternalKHeap<2, ArrivalLabel> oneTripQueue;
+    Queue oneTripQueue;
 
     std::vector<ArrivalLabel> twoTripsArrivalLabels;
-    ExternalKHeap<2, ArrivalLabel> twoTripsQueue;
+    Queue twoTripsQueue;
 
     std::vector<StopId> oneTripTransferParent;
     std::vector<StopId> twoTripsRouteParent;
 
+    // The vertices whose labels may differ from their initial values, they are reset when the next source is set.
+    IndexedSet<false, Vertex> touchedVertices;
+    size_t maxTouchedVertices;
+
     size_t shortcutCandidatesInQueue;
     IndexedSet<false, StopId> shortcutOriginCandidates;
     IndexedMap<Set<StopId>, false, StopId> shortcutDestinationCandidates;
@@ -660,6 +798,11 @@ private:
     int witnessTransferLimit;
 
     int earliestDepartureTime;
+    IndexedMap<StopIndex, false, RouteId> firstReachedStopIndex;
+
+    bool recordDependencies;
+    IndexedSet<false, RouteId> dependencyRoutes;
+    IndexedSet<false, StopId> dependencyStops;
 
 };
 
@@ -0,0 +1,158 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "../../DataStructures/RAPTOR/Data.h"
+#include "../../Helpers/IO/Serialization.h"
+#include "../../Helpers/Helpers.h"
+
+namespace ULTRA {
+
+// The shortcuts found for every source station, together with the parts of the timetable the range search of that
+// station depended on (see RangeSearchUsingStations::run). Given the routes that changed in a new version of the
+// timetable, only the stations whose search used one of these routes, or could board one of them, have to be searched
+// again. The route ids of the unchanged routes must be the same in both versions of the timetable.
+class ShortcutDependencies {
+
+public:
+    struct Shortcut {
+        Shortcut(const StopId from = noStop, const StopId to = noStop, const int travelTime = never) :
+            from(from),
+            to(to),
+            travelTime(travelTime) {
+        }
+        StopId from;
+        StopId to;
+        int travelTime;
+        inline bool operator<(const Shortcut& other) const noexcept {
+            return (from < other.from) || ((from == other.from) && (to < other.to));
+        }
+    };
+
+    struct Source {
+        std::vector<Shortcut> shortcuts;
+        std::vector<RouteId> routes;
+        std::vector<StopId> stops;
+
+        inline void serialize(IO::Serialization& serialize) const noexcept {
+            serialize(shortcuts, routes, stops);
+        }
+
+        inline void deserialize(IO::Deserialization& deserialize) noexcept {
+            deserialize(shortcuts, routes, stops);
+        }
+    };
+
+public:
+    ShortcutDependencies(const size_t numberOfStops = 0, const size_t numberOfRoutes = 0, const int witnessTransferLimit = 15 * 60, const int minDepartureTime = -never, const int maxDepartureTime = never, const bool requireDirectTransfer = false) :
+        sources(numberOfStops),
+        numberOfRoutes(numberOfRoutes),
+        witnessTransferLimit(witnessTransferLimit),
+        minDepartureTime(minDepartureTime),
+        maxDepartureTime(maxDepartureTime),
+        requireDirectTransfer(requireDirectTransfer) {
+    }
+
+    ShortcutDependencies(const std::string& fileName) {
+        deserialize(fileName);
+    }
+
+    inline static ShortcutDependencies FromBinary(const std::string& fileName) noexcept {
+        return ShortcutDependencies(fileName);
+    }
+
+    inline size_t numberOfStops() const noexcept {
+        return sources.size();
+    }
+
+    inline Source& operator[](const StopId stop) noexcept {
+        AssertMsg(stop < numberOfStops(), "Stop " << stop << " is out of range!");
+        return sources[stop];
+    }
+
+    inline const Source& operator[](const StopId stop) const noexcept {
+        AssertMsg(stop < numberOfStops(), "Stop " << stop << " is out of range!");
+        return sources[stop];
+    }
+
+    inline size_t numberOfShortcuts() const noexcept {
+        size_t result = 0;
+        for (const Source& source : sources) {
+            result += source.shortcuts.size();
+        }
+        return result;
+    }
+
+    // The sources whose shortcuts may change if the given routes (ids of the new timetable; removed routes with their
+    // old ids) are modified, added, or removed.
+    inline std::vector<StopId> getAffectedSources(const RAPTOR::Data& data, const std::vector<RouteId>& changedRoutes) const noexcept {
+        Ensure(data.numberOfStops() == numberOfStops(), "The timetable has " << data.numberOfStops() << " stops, but the shortcuts were computed for " << numberOfStops() << " stops!");
+        std::vector<bool> isChangedRoute(numberOfRoutes, false);
+        std::vector<bool> isChangedStop(numberOfStops(), false);
+        for (const RouteId route : changedRoutes) {
+            Ensure(route < std::max(numberOfRoutes, data.numberOfRoutes()), "Route " << route << " is out of range!");
+            if (route < numberOfRoutes) isChangedRoute[route] = true;
+            if (!data.isRoute(route)) continue;
+            for (const StopId stop : data.stopsOfRoute(route)) {
+                isChangedStop[stop] = true;
+            }
+        }
+        std::vector<StopId> result;
+        for (const StopId stop : data.stops()) {
+            const Source& source = sources[stop];
+            bool affected = false;
+            for (const RouteId route : source.routes) {
+                if (!isChangedRoute[route]) continue;
+                affected = true;
+                break;
+            }
+            for (size_t i = 0; (!affected) && (i < source.stops.size()); i++) {
+                affected = isChangedStop[source.stops[i]];
+            }
+            if (affected) result.emplace_back(stop);
+        }
+        return result;
+    }
+
+    inline void serialize(const std::string& fileName) const noexcept {
+        IO::serialize(fileName, sources, numberOfRoutes, witnessTransferLimit, minDepartureTime, maxDepartureTime, requireDirectTransfer);
+    }
+
+    inline void deserialize(const std::string& fileName) noexcept {
+        IO::deserialize(fileName, sources, numberOfRoutes, witnessTransferLimit, minDepartureTime, maxDepartureTime, requireDirectTransfer);
+    }
+
+private:
+    std::vector<Source> sources;
+
+public:
+    size_t numberOfRoutes;
+    int witnessTransferLimit;
+    int minDepartureTime;
+    int maxDepartureTime;
+    bool requireDirectTransfer;
+
+};
+
+}
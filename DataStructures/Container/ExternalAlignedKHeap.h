@@ -0,0 +1,246 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Thomas Pajor, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ExternalKHeap.h"
+
+#include "../../Helpers/Assert.h"
+
+// K-ary heap with the interface of ExternalKHeap, that stores the key of every element next to the pointer to it (the
+// elements have to provide getKey() in addition to hasSmallerKey()). Hence, sifting compares the keys without following
+// the pointers. The entries are shifted such that the K children of a node start at a multiple of K, and the array is
+// aligned accordingly: with integer keys (16 bytes per entry), the children of a node fill exactly one cache line for
+// K = 4 and two cache lines for K = 8.
+// The key of an element is read when it is updated, hence the key of an element must not change while it is on the heap
+// without calling update (changing the key before removing the element is fine).
+template<int logK, typename elementType>
+class ExternalAlignedKHeap {
+
+public:
+    using ElementType = elementType;
+    using KeyType = std::decay_t<decltype(std::declval<const ElementType&>().getKey())>;
+    static constexpr int K = 1 << logK;
+
+private:
+    struct Entry {
+        KeyType key;
+        ElementType* element;
+    };
+
+    static constexpr size_t Alignment = std::max<size_t>(alignof(Entry), std::min<size_t>(K * sizeof(Entry), 64));
+    static_assert((Alignment & (Alignment - 1)) == 0, "The size of the heap entries must be a power of two!");
+
+    template<typename T>
+    struct AlignedAllocator {
+        using value_type = T;
+        AlignedAllocator() = default;
+        template<typename U>
+        AlignedAllocator(const AlignedAllocator<U>&) noexcept {}
+        inline T* allocate(const size_t n) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+        }
+        inline void deallocate(T* const pointer, const size_t) noexcept {
+            ::operator delete(pointer, std::align_val_t(Alignment));
+        }
+        template<typename U>
+        inline bool operator==(const AlignedAllocator<U>&) const noexcept {return true;}
+        template<typename U>
+        inline bool operator!=(const AlignedAllocator<U>&) const noexcept {return false;}
+    };
+
+    // The root is stored at index Offset, hence the first child of node i is stored at index K * (i + 1):
+    static constexpr int Offset = K - 1;
+
+public:
+    ExternalAlignedKHeap(const int initialNumberOfElements = 1000) :
+        numberOfElements(0),
+        heap(Offset) {
+        static_assert(std::is_base_of<ExternalKHeapElement, ElementType>::value, "Element type must inherit from ExternalKHeapElement");
+        heap.reserve(initialNumberOfElements + Offset);
+    }
+
+    inline int size() const {return numberOfElements;}
+    inline bool empty() const {return size() == 0;}
+
+    inline ElementType* extractFront() {
+        AssertMsg(!empty(), "Heap is empty!");
+        ElementType* front = entry(0).element;
+        front->setHeapPosition(-1);
+        numberOfElements--;
+        if (!empty()) {
+            entry(0) = entry(numberOfElements);
+            heap.pop_back();
+            siftDown(0);
+        } else {
+            heap.pop_back();
+        }
+        return front;
+    }
+    inline ElementType* pop() {return extractFront();}
+
+    inline void update(ElementType* const element) {
+        const KeyType key = element->getKey();
+        if (element->getHeapPosition() == -1) {
+            heap.push_back(Entry{key, element});
+            siftUp(numberOfElements++);
+        } else {
+            const int i = element->getHeapPosition();
+            AssertMsg(entry(i).element == element, "Heap is broken!");
+            entry(i).key = key;
+            if ((i > 0) && (key < entry(parent(i)).key)) {
+                siftUp(i);
+            } else {
+                siftDown(i);
+            }
+        }
+    }
+    inline void update(ElementType& element) {update(&element);}
+    inline void push(ElementType* const element) {update(element);}
+    inline void push(ElementType& element) {update(&element);}
+
+    inline void remove(ElementType* const element) {
+        AssertMsg(element->getHeapPosition() != -1, "Element is not in heap!");
+        AssertMsg(entry(element->getHeapPosition()).element == element, "Heap is broken!");
+        const int i = element->getHeapPosition();
+        element->setHeapPosition(-1);
+        numberOfElements--;
+        if (i < numberOfElements) {
+            entry(i) = entry(numberOfElements);
+            heap.pop_back();
+            if ((i > 0) && (entry(i).key < entry(parent(i)).key)) {
+                siftUp(i);
+            } else {
+                siftDown(i);
+            }
+        } else {
+            heap.pop_back();
+        }
+    }
+
+    inline ElementType* front() const {
+        AssertMsg(!empty(), "An empty heap has no front!");
+        return entry(0).element;
+    }
+
+    inline ElementType& min() const {
+        return *front();
+    }
+
+    inline void reserve(int size) {
+        heap.reserve(size + Offset);
+    }
+
+    inline void reset() {
+        clear();
+    }
+
+    inline void clear() {
+        for (int i = 0; i < numberOfElements; ++i) {
+            entry(i).element->setHeapPosition(-1);
+        }
+        numberOfElements = 0;
+        heap.resize(Offset);
+    }
+
+    inline bool contains(const ElementType* const element) const {
+        return element->getHeapPosition() != -1;
+    }
+
+    template<typename Range>
+    inline void build(Range& range) {
+        clear();
+        for (ElementType& element : range) {
+            element.setHeapPosition(numberOfElements++);
+            heap.push_back(Entry{element.getKey(), &element});
+        }
+        for (int i = parent(size() - 1); i >= 0; i--) {
+            siftDown(i);
+        }
+    }
+
+    // Unlike ExternalKHeap::data, the elements are copied, since they are stored together with their keys.
+    inline std::vector<ElementType*> data() const noexcept {
+        std::vector<ElementType*> result;
+        result.reserve(numberOfElements);
+        for (int i = 0; i < numberOfElements; ++i) {
+            result.emplace_back(entry(i).element);
+        }
+        return result;
+    }
+
+protected:
+    inline Entry& entry(const int i) {return heap[i + Offset];}
+    inline const Entry& entry(const int i) const {return heap[i + Offset];}
+
+    inline int parent(const int i) const {return (i - 1) >> logK;}
+    inline int firstChild(const int i) const {return (i << logK) + 1;}
+
+    inline void place(const int i, const Entry& e) {
+        entry(i) = e;
+        e.element->setHeapPosition(i);
+    }
+
+    inline void siftUp(int i) {
+        AssertMsg(i < numberOfElements, "Index i is too large!");
+        const Entry e = entry(i);
+        while (i > 0) {
+            const int parentIndex = parent(i);
+            if (!(e.key < entry(parentIndex).key)) break;
+            place(i, entry(parentIndex));
+            i = parentIndex;
+        }
+        place(i, e);
+    }
+
+    inline void siftDown(int i) {
+        AssertMsg(i < numberOfElements, "Index i is too large!");
+        const Entry e = entry(i);
+        while (true) {
+            const int childIndexLower = firstChild(i);
+            if (childIndexLower >= numberOfElements) break;
+            const int childIndexUpper = std::min(childIndexLower + K, numberOfElements);
+            int minIndex = childIndexLower;
+            KeyType minKey = entry(childIndexLower).key;
+            for (int j = childIndexLower + 1; j < childIndexUpper; ++j) {
+                if (entry(j).key < minKey) {
+                    minIndex = j;
+                    minKey = entry(j).key;
+                }
+            }
+            if (!(minKey < e.key)) break;
+            place(i, entry(minIndex));
+            i = minIndex;
+        }
+        place(i, e);
+    }
+
+private:
+    int numberOfElements;
+    std::vector<Entry, AlignedAllocator<Entry>> heap;
+
+};
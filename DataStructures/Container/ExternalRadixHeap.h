@@ -0,0 +1,233 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Thomas Pajor, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "ExternalKHeap.h"
+
+#include "../../Helpers/Assert.h"
+
+// Monotone radix heap with the interface of ExternalKHeap. The keys are integers (the elements have to provide getKey()
+// in addition to hasSmallerKey()), and an element is kept in the bucket given by the highest bit in which its key differs
+// from the key that was extracted last. Extracting the front only redistributes the elements of the first non-empty
+// bucket, hence every element is moved at most 32 times in total, instead of log(n) comparisons per operation.
+// Keys that are smaller than the last extracted key are allowed (e.g., if a queue is reused for an earlier departure
+// time without being cleared), but all elements are redistributed in this case.
+// The heap position of an element holds its bucket and its index within the bucket.
+template<typename elementType>
+class ExternalRadixHeap {
+
+public:
+    using ElementType = elementType;
+    static constexpr int NumberOfBuckets = 33;
+    static constexpr int BucketBits = 6;
+    static constexpr int BucketMask = (1 << BucketBits) - 1;
+
+public:
+    ExternalRadixHeap(const int = 1000) :
+        numberOfElements(0),
+        last(0),
+        cachedFront(nullptr) {
+        static_assert(std::is_base_of<ExternalKHeapElement, ElementType>::value, "Element type must inherit from ExternalKHeapElement");
+    }
+
+    inline int size() const {return numberOfElements;}
+    inline bool empty() const {return size() == 0;}
+
+    inline ElementType* extractFront() {
+        AssertMsg(!empty(), "Heap is empty!");
+        if (buckets[0].empty()) redistribute();
+        ElementType* front = buckets[0].back();
+        buckets[0].pop_back();
+        front->setHeapPosition(-1);
+        numberOfElements--;
+        cachedFront = nullptr;
+        return front;
+    }
+    inline ElementType* pop() {return extractFront();}
+
+    inline void update(ElementType* const element) {
+        const uint32_t key = keyOf(element);
+        if (element == cachedFront) {
+            cachedFront = nullptr;
+        } else if ((cachedFront != nullptr) && (key < keyOf(cachedFront))) {
+            cachedFront = element;
+        }
+        if (key < last) {
+            if (element->isOnHeap()) {
+                removeFromBucket(element);
+            } else {
+                numberOfElements++;
+            }
+            rebase(key);
+            insertIntoBucket(element, 0);
+        } else if (element->isOnHeap()) {
+            const int bucket = bucketOf(key);
+            if (bucket == (element->getHeapPosition() & BucketMask)) return;
+            removeFromBucket(element);
+            insertIntoBucket(element, bucket);
+        } else {
+            if (empty()) last = key;
+            insertIntoBucket(element, bucketOf(key));
+            numberOfElements++;
+        }
+    }
+    inline void update(ElementType& element) {update(&element);}
+    inline void push(ElementType* const element) {update(element);}
+    inline void push(ElementType& element) {update(&element);}
+
+    inline void remove(ElementType* const element) {
+        AssertMsg(element->getHeapPosition() != -1, "Element is not in heap!");
+        removeFromBucket(element);
+        element->setHeapPosition(-1);
+        numberOfElements--;
+        if (element == cachedFront) cachedFront = nullptr;
+    }
+
+    // Does not modify the buckets (this is done by the next extractFront), the element with the smallest key is cached
+    // instead, since it has to be searched for in the first non-empty bucket.
+    inline ElementType* front() const {
+        AssertMsg(!empty(), "An empty heap has no front!");
+        if (!buckets[0].empty()) return buckets[0].back();
+        if (cachedFront == nullptr) {
+            int bucket = 1;
+            while (buckets[bucket].empty()) bucket++;
+            cachedFront = buckets[bucket][0];
+            for (ElementType* const element : buckets[bucket]) {
+                if (keyOf(element) < keyOf(cachedFront)) cachedFront = element;
+            }
+        }
+        return cachedFront;
+    }
+
+    inline ElementType& min() const {
+        return *front();
+    }
+
+    inline void reserve(int) {
+    }
+
+    inline void reset() {
+        clear();
+    }
+
+    inline void clear() {
+        for (std::vector<ElementType*>& bucket : buckets) {
+            for (ElementType* const element : bucket) {
+                element->setHeapPosition(-1);
+            }
+            bucket.clear();
+        }
+        numberOfElements = 0;
+        last = 0;
+        cachedFront = nullptr;
+    }
+
+    inline bool contains(const ElementType* const element) const {
+        return element->getHeapPosition() != -1;
+    }
+
+    template<typename Range>
+    inline void build(Range& range) {
+        clear();
+        for (ElementType& element : range) {
+            update(&element);
+        }
+    }
+
+    // Unlike ExternalKHeap::data, the elements are copied, since they are spread over the buckets.
+    inline std::vector<ElementType*> data() const noexcept {
+        std::vector<ElementType*> result;
+        result.reserve(numberOfElements);
+        for (const std::vector<ElementType*>& bucket : buckets) {
+            result.insert(result.end(), bucket.begin(), bucket.end());
+        }
+        return result;
+    }
+
+protected:
+    // Maps the keys to unsigned integers with the same order:
+    inline static uint32_t keyOf(const ElementType* const element) noexcept {
+        return static_cast<uint32_t>(element->getKey()) ^ 0x80000000u;
+    }
+
+    inline int bucketOf(const uint32_t key) const noexcept {
+        return (key == last) ? 0 : 32 - __builtin_clz(key ^ last);
+    }
+
+    inline void insertIntoBucket(ElementType* const element, const int bucket) {
+        AssertMsg(buckets[bucket].size() < (size_t(1) << (31 - BucketBits)), "Bucket " << bucket << " has too many elements!");
+        element->setHeapPosition((static_cast<int>(buckets[bucket].size()) << BucketBits) | bucket);
+        buckets[bucket].emplace_back(element);
+    }
+
+    inline void removeFromBucket(ElementType* const element) {
+        const int bucket = element->getHeapPosition() & BucketMask;
+        const int index = element->getHeapPosition() >> BucketBits;
+        AssertMsg(buckets[bucket][index] == element, "Heap is broken!");
+        buckets[bucket][index] = buckets[bucket].back();
+        buckets[bucket][index]->setHeapPosition((index << BucketBits) | bucket);
+        buckets[bucket].pop_back();
+    }
+
+    // Moves the elements of the first non-empty bucket to the smaller buckets, relative to their smallest key.
+    inline void redistribute() {
+        int bucket = 1;
+        while (buckets[bucket].empty()) bucket++;
+        last = keyOf(buckets[bucket][0]);
+        for (const ElementType* const element : buckets[bucket]) {
+            if (keyOf(element) < last) last = keyOf(element);
+        }
+        for (ElementType* const element : buckets[bucket]) {
+            insertIntoBucket(element, bucketOf(keyOf(element)));
+        }
+        buckets[bucket].clear();
+    }
+
+    // Redistributes all elements relative to key, which is smaller than the last extracted key.
+    inline void rebase(const uint32_t key) {
+        last = key;
+        for (int bucket = 1; bucket < NumberOfBuckets; bucket++) {
+            buffer.swap(buckets[bucket]);
+            for (ElementType* const element : buffer) {
+                insertIntoBucket(element, bucketOf(keyOf(element)));
+            }
+            buffer.clear();
+        }
+        buffer.swap(buckets[0]);
+        for (ElementType* const element : buffer) {
+            insertIntoBucket(element, bucketOf(keyOf(element)));
+        }
+        buffer.clear();
+    }
+
+private:
+    int numberOfElements;
+    uint32_t last;
+    std::array<std::vector<ElementType*>, NumberOfBuckets> buckets;
+    std::vector<ElementType*> buffer;
+    mutable ElementType* cachedFront;
+
+};
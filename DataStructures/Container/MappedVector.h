@@ -0,0 +1,215 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <utility>
+
+#include "../../Helpers/Assert.h"
+#include "../../Helpers/IO/Serialization.h"
+#include "../../Helpers/IO/MappedArrays.h"
+#include "../../Helpers/Vector/Vector.h"
+
+// Read-mostly array, which either owns its values (std::vector) or is a read-only view of an array contained in a memory mapped file.
+// Read access is the same in both cases. Modifying a mapped array first copies its values into owned memory.
+template<typename VALUE_TYPE>
+class MappedVector {
+
+public:
+    using ValueType = VALUE_TYPE;
+    using Type = MappedVector<ValueType>;
+    using Iterator = const ValueType*;
+
+public:
+    MappedVector() :
+        first(nullptr),
+        count(0) {
+    }
+
+    MappedVector(std::vector<ValueType>&& vector) :
+        values(std::move(vector)) {
+        update();
+    }
+
+    MappedVector(const IO::MappedArrays& file, const std::string& name) {
+        map(file, name);
+    }
+
+    MappedVector(const MappedVector& other) :
+        values(other.values),
+        mapping(other.mapping),
+        first(other.first),
+        count(other.count) {
+        update();
+    }
+
+    MappedVector(MappedVector&& other) :
+        values(std::move(other.values)),
+        mapping(std::move(other.mapping)),
+        first(other.first),
+        count(other.count) {
+        update();
+        other.clear();
+    }
+
+    inline MappedVector& operator=(const MappedVector& other) noexcept {
+        if (this == &other) return *this;
+        values = other.values;
+        mapping = other.mapping;
+        first = other.first;
+        count = other.count;
+        update();
+        return *this;
+    }
+
+    inline MappedVector& operator=(MappedVector&& other) noexcept {
+        if (this == &other) return *this;
+        values = std::move(other.values);
+        mapping = std::move(other.mapping);
+        first = other.first;
+        count = other.count;
+        update();
+        other.clear();
+        return *this;
+    }
+
+    inline MappedVector& operator=(std::vector<ValueType>&& other) noexcept {
+        values = std::move(other);
+        mapping.reset();
+        update();
+        return *this;
+    }
+
+public:
+    inline size_t size() const noexcept {
+        return count;
+    }
+
+    inline bool empty() const noexcept {
+        return count == 0;
+    }
+
+    inline bool isMapped() const noexcept {
+        return mapping != nullptr;
+    }
+
+    inline const ValueType& operator[](const size_t i) const noexcept {
+        AssertMsg(i < count, "Index " << i << " is out of range!");
+        return first[i];
+    }
+
+    inline const ValueType* data() const noexcept {
+        return first;
+    }
+
+    inline Iterator begin() const noexcept {
+        return first;
+    }
+
+    inline Iterator end() const noexcept {
+        return first + count;
+    }
+
+    inline const ValueType& front() const noexcept {
+        AssertMsg(!empty(), "Vector is empty!");
+        return first[0];
+    }
+
+    inline const ValueType& back() const noexcept {
+        AssertMsg(!empty(), "Vector is empty!");
+        return first[count - 1];
+    }
+
+    inline long long byteSize() const noexcept {
+        return isMapped() ? 0 : Vector::byteSize(values);
+    }
+
+public:
+    template<typename... ARGS>
+    inline void emplace_back(ARGS&&... args) noexcept {
+        detach();
+        values.emplace_back(std::forward<ARGS>(args)...);
+        update();
+    }
+
+    inline void reserve(const size_t capacity) noexcept {
+        detach();
+        values.reserve(capacity);
+        update();
+    }
+
+    inline void clear() noexcept {
+        std::vector<ValueType>().swap(values);
+        mapping.reset();
+        update();
+    }
+
+    // Gives write access to the values; a mapped array is copied into owned memory first.
+    inline ValueType* mutableData() noexcept {
+        detach();
+        return values.data();
+    }
+
+    inline void map(const IO::MappedArrays& file, const std::string& name) noexcept {
+        std::vector<ValueType>().swap(values);
+        mapping = file.getFile();
+        first = file.get<ValueType>(name, count);
+    }
+
+public:
+    inline void serialize(IO::Serialization& serialize) const noexcept {
+        if (isMapped()) {
+            serialize(std::vector<ValueType>(begin(), end()));
+        } else {
+            serialize(values);
+        }
+    }
+
+    inline void deserialize(IO::Deserialization& deserialize) noexcept {
+        mapping.reset();
+        deserialize(values);
+        update();
+    }
+
+private:
+    inline void detach() noexcept {
+        if (!isMapped()) return;
+        values.assign(begin(), end());
+        mapping.reset();
+        update();
+    }
+
+    inline void update() noexcept {
+        if (isMapped()) return;
+        first = values.data();
+        count = values.size();
+    }
+
+private:
+    std::vector<ValueType> values;
+    std::shared_ptr<const IO::MemoryMappedFile> mapping;
+
+    const ValueType* first;
+    size_t count;
+
+};
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 #include <sstream>
@@ -106,6 +107,22 @@ public:
         return neighbors;
     }
 
+    // The (at most) k vertices within maxDistance of p, sorted by increasing distance to p.
+    inline std::vector<Vertex> getNearestNeighbors(const Geometry::Point& p, const size_t k, const double maxDistance) const noexcept {
+        std::vector<std::pair<double, Vertex>> candidates;
+        for (const Vertex vertex : getNeighbors(p, maxDistance)) {
+            candidates.emplace_back(metric.distanceSquare(p, coordinates[vertex]), vertex);
+        }
+        const size_t count = std::min(k, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+        std::vector<Vertex> result;
+        result.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            result.emplace_back(candidates[i].second);
+        }
+        return result;
+    }
+
     inline size_t numVertices() const noexcept {
         return vertexCount;
     }
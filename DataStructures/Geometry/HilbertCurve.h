@@ -0,0 +1,55 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Point.h"
+#include "Rectangle.h"
+
+namespace Geometry {
+
+// Position of p along a Hilbert curve filling the box (with 2^16 cells per side). Points that are close along the
+// curve are close in space, hence sorting points by their index yields an order that preserves locality.
+inline uint64_t hilbertCurveIndex(const Rectangle& box, const Point& p) noexcept {
+    constexpr uint64_t n = uint64_t(1) << 16;
+    const double width = std::max(box.max.x - box.min.x, 1e-12);
+    const double height = std::max(box.max.y - box.min.y, 1e-12);
+    uint64_t x = std::min<uint64_t>(n - 1, std::max(0.0, (p.x - box.min.x) / width) * (n - 1));
+    uint64_t y = std::min<uint64_t>(n - 1, std::max(0.0, (p.y - box.min.y) / height) * (n - 1));
+    uint64_t result = 0;
+    for (uint64_t s = n / 2; s > 0; s /= 2) {
+        const uint64_t rx = (x & s) > 0;
+        const uint64_t ry = (y & s) > 0;
+        result += s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return result;
+}
+
+}
@@ -695,7 +695,7 @@ private:
 
         beginOut.swap(newBeginOut);
         checkVectorSize();
-        Assert(satisfiesInvariants());
+        AssertMsg(satisfiesInvariants(), "Invariants not satisfied!");
     }
 
 public:
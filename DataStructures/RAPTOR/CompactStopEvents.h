@@ -0,0 +1,140 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "Data.h"
+
+#include "../../Helpers/Assert.h"
+#include "../../Helpers/String/String.h"
+#include "../../Helpers/Vector/Vector.h"
+
+namespace RAPTOR {
+
+// Compact copy of the stop events of the routes, for the route scans of the queries. Instead of two absolute 32-bit times
+// per stop event, every trip stores a base time, and every stop event its two times as 16-bit offsets from that base,
+// which halves the memory scanned by the queries. Routes with a trip lasting longer than the largest offset (about 18
+// hours) are not compressed, they have to be scanned using the stop events of the data.
+class CompactStopEvents {
+
+public:
+    struct Offsets {
+        uint16_t arrival;
+        uint16_t departure;
+    };
+
+    inline static constexpr int MaxOffset = std::numeric_limits<uint16_t>::max();
+
+public:
+    CompactStopEvents(const Data& data) :
+        numberOfStopEvents(data.numberOfStopEvents()),
+        implicitBufferTimes(data.hasImplicitBufferTimes()),
+        firstTripOfRoute(1, 0),
+        firstOffsetsOfRoute(1, 0),
+        isCompact(data.numberOfRoutes(), false) {
+        for (const RouteId route : data.routes()) {
+            const size_t tripSize = data.numberOfStopsInRoute(route);
+            const size_t numberOfTrips = data.numberOfTripsInRoute(route);
+            const StopEvent* stopEvents = data.firstTripOfRoute(route);
+            std::vector<int> bases(numberOfTrips, std::numeric_limits<int>::max());
+            bool compressible = true;
+            for (size_t trip = 0; trip < numberOfTrips; trip++) {
+                int max = std::numeric_limits<int>::min();
+                for (size_t i = trip * tripSize; i < (trip + 1) * tripSize; i++) {
+                    bases[trip] = std::min({bases[trip], stopEvents[i].arrivalTime, stopEvents[i].departureTime});
+                    max = std::max({max, stopEvents[i].arrivalTime, stopEvents[i].departureTime});
+                }
+                compressible &= (static_cast<long long>(max) - bases[trip] <= MaxOffset);
+            }
+            if (compressible) {
+                isCompact[route] = true;
+                tripBase.insert(tripBase.end(), bases.begin(), bases.end());
+                for (size_t trip = 0; trip < numberOfTrips; trip++) {
+                    for (size_t i = trip * tripSize; i < (trip + 1) * tripSize; i++) {
+                        offsets.emplace_back(Offsets{uint16_t(stopEvents[i].arrivalTime - bases[trip]), uint16_t(stopEvents[i].departureTime - bases[trip])});
+                    }
+                }
+            }
+            firstTripOfRoute.emplace_back(tripBase.size());
+            firstOffsetsOfRoute.emplace_back(offsets.size());
+        }
+    }
+
+    inline bool isCompactRoute(const RouteId route) const noexcept {
+        return isCompact[route];
+    }
+
+    // The base times of the trips of the route, by increasing departure time (as the trips of the data).
+    inline const int* tripBasesOfRoute(const RouteId route) const noexcept {
+        AssertMsg(isCompactRoute(route), "Route " << route << " is not compressed!");
+        return tripBase.data() + firstTripOfRoute[route];
+    }
+
+    // The offsets of the stop events of the route, trip by trip (as the stop events of the data).
+    inline const Offsets* offsetsOfRoute(const RouteId route) const noexcept {
+        AssertMsg(isCompactRoute(route), "Route " << route << " is not compressed!");
+        return offsets.data() + firstOffsetsOfRoute[route];
+    }
+
+    inline bool isCompactCopyOf(const Data& data) const noexcept {
+        return (isCompact.size() == data.numberOfRoutes()) && (numberOfStopEvents == data.numberOfStopEvents()) && (implicitBufferTimes == data.hasImplicitBufferTimes());
+    }
+
+    inline size_t numberOfCompactRoutes() const noexcept {
+        return std::count(isCompact.begin(), isCompact.end(), true);
+    }
+
+    inline long long byteSize() const noexcept {
+        long long result = Vector::byteSize(firstTripOfRoute);
+        result += Vector::byteSize(tripBase);
+        result += Vector::byteSize(firstOffsetsOfRoute);
+        result += Vector::byteSize(offsets);
+        result += Vector::byteSize(isCompact);
+        return result;
+    }
+
+    inline void printInfo() const noexcept {
+        std::cout << "Compact stop events:" << std::endl;
+        std::cout << "   Compressed routes:   " << String::prettyInt(numberOfCompactRoutes()) << " / " << String::prettyInt(isCompact.size()) << std::endl;
+        std::cout << "   Compressed events:   " << String::prettyInt(offsets.size()) << " / " << String::prettyInt(numberOfStopEvents) << std::endl;
+        std::cout << "   Memory:              " << String::bytesToString(byteSize()) << " (instead of " << String::bytesToString(numberOfStopEvents * sizeof(StopEvent)) << ")" << std::endl;
+    }
+
+private:
+    size_t numberOfStopEvents;
+    bool implicitBufferTimes;
+
+    std::vector<size_t> firstTripOfRoute;
+    std::vector<int> tripBase;
+
+    std::vector<size_t> firstOffsetsOfRoute;
+    std::vector<Offsets> offsets;
+
+    std::vector<bool> isCompact;
+
+};
+
+}
@@ -34,17 +34,21 @@
 #include "Entities/TripIterator.h"
 
 #include "../Container/Map.h"
+#include "../Container/MappedVector.h"
 #include "../Container/Set.h"
+#include "../Geometry/HilbertCurve.h"
 #include "../Graph/Graph.h"
 #include "../Intermediate/Data.h"
 
 #include "../../Helpers/Assert.h"
 #include "../../Helpers/Timer.h"
 #include "../../Helpers/IO/Serialization.h"
+#include "../../Helpers/IO/MappedArrays.h"
 #include "../../Helpers/String/String.h"
 #include "../../Helpers/String/Enumeration.h"
 #include "../../Helpers/Ranges/Range.h"
 #include "../../Helpers/Ranges/SubRange.h"
+#include "../../Helpers/Vector/Permutation.h"
 
 #include "../../Algorithms/Dijkstra/Dijkstra.h"
 
@@ -54,6 +58,9 @@ using TransferGraph = ::TransferGraph;
 
 class Data {
 
+public:
+    inline static constexpr size_t MappedArraysVersion = 2;
+
 private:
     Data() :
         implicitDepartureBufferTimes(false),
@@ -67,6 +74,12 @@ public:
         return data;
     }
 
+    inline static Data FromMappedBinary(const std::string& fileName, const std::string& sourceFileName) noexcept {
+        Data data;
+        data.deserializeMapped(fileName, sourceFileName);
+        return data;
+    }
+
     inline static Data FromIntermediate(const Intermediate::Data& inter, const int routeType = 1) noexcept {
         Data data;
         std::vector<std::vector<Intermediate::Trip>> routes;
@@ -166,19 +179,19 @@ public:
         return firstStopIdOfRoute[route] + stopIndex;
     }
 
-    inline SubRange<std::vector<RouteSegment>> routesContainingStop(const StopId stop) const noexcept {
+    inline SubRange<MappedVector<RouteSegment>> routesContainingStop(const StopId stop) const noexcept {
         AssertMsg(isStop(stop), "The id " << stop << " does not represent a stop!");
-        return SubRange<std::vector<RouteSegment>>(routeSegments, firstRouteSegmentOfStop, stop);
+        return SubRange<MappedVector<RouteSegment>>(routeSegments, firstRouteSegmentOfStop[stop], firstRouteSegmentOfStop[stop + 1]);
     }
 
-    inline SubRange<std::vector<StopEvent>> stopEventsOfRoute(const RouteId route) const noexcept {
+    inline SubRange<MappedVector<StopEvent>> stopEventsOfRoute(const RouteId route) const noexcept {
         AssertMsg(isRoute(route), "The id " << route << " does not represent a route!");
-        return SubRange<std::vector<StopEvent>>(stopEvents, firstStopEventOfRoute, route);
+        return SubRange<MappedVector<StopEvent>>(stopEvents, firstStopEventOfRoute[route], firstStopEventOfRoute[route + 1]);
     }
 
-    inline SubRange<std::vector<StopId>> stopsOfRoute(const RouteId route) const noexcept {
+    inline SubRange<MappedVector<StopId>> stopsOfRoute(const RouteId route) const noexcept {
         AssertMsg(isRoute(route), "The id " << route << " does not represent a route!");
-        return SubRange<std::vector<StopId>>(stopIds, firstStopIdOfRoute, route);
+        return SubRange<MappedVector<StopId>>(stopIds, firstStopIdOfRoute[route], firstStopIdOfRoute[route + 1]);
     }
 
     inline const StopId* stopArrayOfRoute(const RouteId route) const noexcept {
@@ -250,12 +263,12 @@ public:
 private:
     inline StopEvent* firstTripOfRoute(const RouteId route) noexcept {
         AssertMsg(isRoute(route), "The id " << route << " does not represent a route!");
-        return &(stopEvents[firstStopEventOfRoute[route]]);
+        return stopEvents.mutableData() + firstStopEventOfRoute[route];
     }
 
     inline StopEvent* lastTripOfRoute(const RouteId route) noexcept {
         AssertMsg(isRoute(route), "The id " << route << " does not represent a route!");
-        return &(stopEvents[firstStopEventOfRoute[route + 1] - numberOfStopsInRoute(route)]);
+        return stopEvents.mutableData() + firstStopEventOfRoute[route + 1] - numberOfStopsInRoute(route);
     }
 
     template<typename ADJUST>
@@ -364,6 +377,126 @@ public:
         }
     }
 
+    // Stop ids in the order of the input (e.g. GTFS) scatter the stops of a route, and the neighbors of a stop in the
+    // transfer graph, in memory. In this numbering, the routes are traversed along a Hilbert curve (by their first stop),
+    // and each stop gets the next id when it is seen for the first time. The remaining stops (without routes) follow,
+    // also along the Hilbert curve.
+    inline Permutation localityPreservingStopPermutation() const noexcept {
+        const Geometry::Rectangle box = boundingBox();
+        std::vector<uint64_t> stopIndex(numberOfStops());
+        for (const StopId stop : stops()) {
+            stopIndex[stop] = Geometry::hilbertCurveIndex(box, stopData[stop].coordinates);
+        }
+        std::vector<uint64_t> routeIndex(numberOfRoutes());
+        for (const RouteId route : routes()) {
+            routeIndex[route] = stopIndex[stopArrayOfRoute(route)[0]];
+        }
+        Permutation permutation(numberOfStops());
+        std::vector<bool> isNumbered(numberOfStops(), false);
+        size_t nextId = 0;
+        const auto number = [&](const StopId stop) {
+            if (isNumbered[stop]) return;
+            isNumbered[stop] = true;
+            permutation[stop] = nextId++;
+        };
+        for (const size_t route : Order(Construct::Sort, routeIndex)) {
+            const StopId* stopsOfCurrentRoute = stopArrayOfRoute(RouteId(route));
+            for (size_t i = 0; i < numberOfStopsInRoute(RouteId(route)); i++) {
+                number(stopsOfCurrentRoute[i]);
+            }
+        }
+        for (const size_t stop : Order(Construct::Sort, stopIndex)) {
+            number(StopId(stop));
+        }
+        AssertMsg(permutation.isValid(), "The stop permutation is not valid!");
+        return permutation;
+    }
+
+    // Routes that serve the same stops get close ids: the routes are ordered by the smallest id of their stops.
+    inline Permutation localityPreservingRoutePermutation() const noexcept {
+        std::vector<StopId> minStopId(numberOfRoutes(), noStop);
+        for (const RouteId route : routes()) {
+            const StopId* stopsOfCurrentRoute = stopArrayOfRoute(route);
+            for (size_t i = 0; i < numberOfStopsInRoute(route); i++) {
+                minStopId[route] = std::min(minStopId[route], stopsOfCurrentRoute[i]);
+            }
+        }
+        return Permutation(Construct::Invert, Order(Construct::Sort, minStopId));
+    }
+
+    // Stop s becomes stop permutation[s]. The vertices of the transfer graph which are not stops keep their ids.
+    inline void applyStopPermutation(const Permutation& permutation) noexcept {
+        AssertMsg(permutation.size() == numberOfStops(), "Permutation has the wrong size! (permutation.size(): " << permutation.size() << ", numberOfStops: " << numberOfStops() << ")");
+        const Order order(Construct::Invert, permutation);
+        std::vector<size_t> newFirstRouteSegmentOfStop;
+        std::vector<RouteSegment> newRouteSegments;
+        newFirstRouteSegmentOfStop.reserve(numberOfStops() + 1);
+        newRouteSegments.reserve(numberOfRouteSegments());
+        for (const StopId stop : stops()) {
+            newFirstRouteSegmentOfStop.emplace_back(newRouteSegments.size());
+            const StopId oldStop(order[stop]);
+            for (size_t i = firstRouteSegmentOfStop[oldStop]; i < firstRouteSegmentOfStop[oldStop + 1]; i++) {
+                newRouteSegments.emplace_back(routeSegments[i]);
+            }
+        }
+        newFirstRouteSegmentOfStop.emplace_back(newRouteSegments.size());
+        std::vector<StopId> newStopIds(stopIds.begin(), stopIds.end());
+        permutation.mapPermutation(newStopIds);
+        firstRouteSegmentOfStop = std::move(newFirstRouteSegmentOfStop);
+        routeSegments = std::move(newRouteSegments);
+        stopIds = std::move(newStopIds);
+        permutation.permutate(stopData);
+        transferGraph.applyVertexPermutation(extendToVertices(permutation, transferGraph.numVertices()));
+    }
+
+    // Route r becomes route permutation[r]. The trips of a route, and the stop events of a trip, keep their order.
+    inline void applyRoutePermutation(const Permutation& permutation) noexcept {
+        AssertMsg(permutation.size() == numberOfRoutes(), "Permutation has the wrong size! (permutation.size(): " << permutation.size() << ", numberOfRoutes: " << numberOfRoutes() << ")");
+        const Order order(Construct::Invert, permutation);
+        std::vector<size_t> newFirstStopIdOfRoute;
+        std::vector<size_t> newFirstStopEventOfRoute;
+        std::vector<StopId> newStopIds;
+        std::vector<StopEvent> newStopEvents;
+        newFirstStopIdOfRoute.reserve(numberOfRoutes() + 1);
+        newFirstStopEventOfRoute.reserve(numberOfRoutes() + 1);
+        newStopIds.reserve(stopIds.size());
+        newStopEvents.reserve(numberOfStopEvents());
+        for (const RouteId route : routes()) {
+            const RouteId oldRoute(order[route]);
+            newFirstStopIdOfRoute.emplace_back(newStopIds.size());
+            newStopIds.insert(newStopIds.end(), stopIds.begin() + firstStopIdOfRoute[oldRoute], stopIds.begin() + firstStopIdOfRoute[oldRoute + 1]);
+            newFirstStopEventOfRoute.emplace_back(newStopEvents.size());
+            newStopEvents.insert(newStopEvents.end(), stopEvents.begin() + firstStopEventOfRoute[oldRoute], stopEvents.begin() + firstStopEventOfRoute[oldRoute + 1]);
+        }
+        newFirstStopIdOfRoute.emplace_back(newStopIds.size());
+        newFirstStopEventOfRoute.emplace_back(newStopEvents.size());
+        std::vector<RouteSegment> newRouteSegments(routeSegments.begin(), routeSegments.end());
+        for (const StopId stop : stops()) {
+            for (size_t i = firstRouteSegmentOfStop[stop]; i < firstRouteSegmentOfStop[stop + 1]; i++) {
+                newRouteSegments[i].routeId = permutation.permutate(newRouteSegments[i].routeId);
+            }
+            std::sort(newRouteSegments.begin() + firstRouteSegmentOfStop[stop], newRouteSegments.begin() + firstRouteSegmentOfStop[stop + 1], [](const RouteSegment& a, const RouteSegment& b) {
+                return (a.routeId < b.routeId) || ((a.routeId == b.routeId) && (a.stopIndex < b.stopIndex));
+            });
+        }
+        firstStopIdOfRoute = std::move(newFirstStopIdOfRoute);
+        firstStopEventOfRoute = std::move(newFirstStopEventOfRoute);
+        stopIds = std::move(newStopIds);
+        stopEvents = std::move(newStopEvents);
+        routeSegments = std::move(newRouteSegments);
+        permutation.permutate(routeData);
+    }
+
+    // The permutation of the stops, extended to all vertices of the transfer graph (the other vertices keep their ids).
+    inline static Permutation extendToVertices(const Permutation& stopPermutation, const size_t numberOfVertices) noexcept {
+        AssertMsg(stopPermutation.size() <= numberOfVertices, "There are more stops than vertices!");
+        Permutation result(Construct::Id, numberOfVertices);
+        for (size_t stop = 0; stop < stopPermutation.size(); stop++) {
+            result[stop] = stopPermutation[stop];
+        }
+        return result;
+    }
+
 public:
     inline void printInfo() const noexcept {
         size_t stopEventCount = stopEvents.size();
@@ -387,9 +520,12 @@ public:
         std::cout << "   Bounding Box:             " << std::setw(12) << boundingBox() << std::endl;
     }
 
+    // A checksum of the data is written to fileName.checksum, it identifies the data in the files derived from it (see
+    // serializeMapped).
     inline void serialize(const std::string& fileName) const noexcept {
         IO::serialize(fileName, firstRouteSegmentOfStop, firstStopIdOfRoute, firstStopEventOfRoute, routeSegments, stopIds, stopEvents, stopData, routeData, implicitDepartureBufferTimes, implicitArrivalBufferTimes);
         transferGraph.writeBinary(fileName + ".graph");
+        IO::serialize(fileName + ".checksum", checksum());
     }
 
     inline void deserialize(const std::string& fileName) noexcept {
@@ -397,13 +533,82 @@ public:
         transferGraph.readBinary(fileName + ".graph");
     }
 
+    // The flat arrays are written to fileName.arrays, using an aligned layout which can be mapped into memory and used in place.
+    // Buffer times are stored as they are, hence writing the data after useImplicitDepartureBufferTimes() avoids copying the
+    // mapped stop events when the data is loaded for queries.
+    // The checksum of sourceFileName (the same data, written by serialize) is recorded, so that the mapped data is only used
+    // together with the files it was written for. It is compared to sourceFileName.checksum when loading, hence the source
+    // files themselves are not read.
+    inline void serializeMapped(const std::string& fileName, const std::string& sourceFileName) const noexcept {
+        const uint64_t sourceChecksum = IO::deserialize<uint64_t>(sourceFileName + ".checksum");
+        IO::serialize(fileName, stopData, routeData, implicitDepartureBufferTimes, implicitArrivalBufferTimes, sourceChecksum, numberOfStops(), numberOfRoutes(), numberOfStopEvents());
+        IO::MappedArraysWriter arrays(fileName + ".arrays", MappedArraysVersion);
+        arrays.add("firstRouteSegmentOfStop", firstRouteSegmentOfStop.data(), firstRouteSegmentOfStop.size());
+        arrays.add("firstStopIdOfRoute", firstStopIdOfRoute.data(), firstStopIdOfRoute.size());
+        arrays.add("firstStopEventOfRoute", firstStopEventOfRoute.data(), firstStopEventOfRoute.size());
+        arrays.add("routeSegments", routeSegments.data(), routeSegments.size());
+        arrays.add("stopIds", stopIds.data(), stopIds.size());
+        arrays.add("stopEvents", stopEvents.data(), stopEvents.size());
+        arrays.write();
+        transferGraph.writeBinary(fileName + ".graph");
+    }
+
+    inline void deserializeMapped(const std::string& fileName, const std::string& sourceFileName) noexcept {
+        uint64_t sourceChecksum = 0;
+        size_t stopCount = 0;
+        size_t routeCount = 0;
+        size_t stopEventCount = 0;
+        IO::deserialize(fileName, stopData, routeData, implicitDepartureBufferTimes, implicitArrivalBufferTimes, sourceChecksum, stopCount, routeCount, stopEventCount);
+        Ensure(IO::deserialize<uint64_t>(sourceFileName + ".checksum") == sourceChecksum, "File " << fileName << " was not written for " << sourceFileName << "!");
+        const IO::MappedArrays arrays(fileName + ".arrays", MappedArraysVersion);
+        firstRouteSegmentOfStop.map(arrays, "firstRouteSegmentOfStop");
+        firstStopIdOfRoute.map(arrays, "firstStopIdOfRoute");
+        firstStopEventOfRoute.map(arrays, "firstStopEventOfRoute");
+        routeSegments.map(arrays, "routeSegments");
+        stopIds.map(arrays, "stopIds");
+        stopEvents.map(arrays, "stopEvents");
+        transferGraph.readBinary(fileName + ".graph");
+        Ensure(numberOfStops() == stopCount && firstRouteSegmentOfStop.size() == stopCount + 1, "The mapped data in " << fileName << " does not have " << stopCount << " stops!");
+        Ensure(numberOfRoutes() == routeCount && firstStopEventOfRoute.size() == routeCount + 1, "The mapped data in " << fileName << " does not have " << routeCount << " routes!");
+        Ensure(numberOfStopEvents() == stopEventCount, "The mapped data in " << fileName << " does not have " << stopEventCount << " stop events!");
+    }
+
+    // FNV-1a of the routes, the stop events and the transfers (or shortcuts), only computed when the data is written :
+    inline uint64_t checksum() const noexcept {
+        uint64_t result = 14695981039346656037ull;
+        addToChecksum(result, firstRouteSegmentOfStop);
+        addToChecksum(result, firstStopIdOfRoute);
+        addToChecksum(result, firstStopEventOfRoute);
+        addToChecksum(result, routeSegments);
+        addToChecksum(result, stopIds);
+        addToChecksum(result, stopEvents);
+        for (const Vertex from : transferGraph.vertices()) {
+            for (const Edge edge : transferGraph.edgesFrom(from)) {
+                result = (result ^ uint64_t(from)) * 1099511628211ull;
+                result = (result ^ uint64_t(transferGraph.get(ToVertex, edge))) * 1099511628211ull;
+                result = (result ^ uint64_t(uint32_t(transferGraph.get(TravelTime, edge)))) * 1099511628211ull;
+            }
+        }
+        return result;
+    }
+
+private:
+    template<typename ARRAY>
+    inline static void addToChecksum(uint64_t& checksum, const ARRAY& array) noexcept {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(array.data());
+        for (size_t i = 0; i < array.size() * sizeof(array[0]); i++) {
+            checksum = (checksum ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+public:
     inline long long byteSize() const noexcept {
-        long long result = Vector::byteSize(firstRouteSegmentOfStop);
-        result += Vector::byteSize(firstStopIdOfRoute);
-        result += Vector::byteSize(firstStopEventOfRoute);
-        result += Vector::byteSize(routeSegments);
-        result += Vector::byteSize(stopIds);
-        result += Vector::byteSize(stopEvents);
+        long long result = firstRouteSegmentOfStop.byteSize();
+        result += firstStopIdOfRoute.byteSize();
+        result += firstStopEventOfRoute.byteSize();
+        result += routeSegments.byteSize();
+        result += stopIds.byteSize();
+        result += stopEvents.byteSize();
         result += Vector::byteSize(stopData);
         result += Vector::byteSize(routeData);
         result += transferGraph.byteSize();
@@ -412,15 +617,15 @@ public:
     }
 
 public:
-    std::vector<size_t> firstRouteSegmentOfStop;
+    MappedVector<size_t> firstRouteSegmentOfStop;
 
-    std::vector<size_t> firstStopIdOfRoute;
-    std::vector<size_t> firstStopEventOfRoute;
+    MappedVector<size_t> firstStopIdOfRoute;
+    MappedVector<size_t> firstStopEventOfRoute;
 
-    std::vector<RouteSegment> routeSegments;
+    MappedVector<RouteSegment> routeSegments;
 
-    std::vector<StopId> stopIds;
-    std::vector<StopEvent> stopEvents;
+    MappedVector<StopId> stopIds;
+    MappedVector<StopEvent> stopEvents;
 
     std::vector<Stop> stopData;
     std::vector<Route> routeData;
@@ -0,0 +1,143 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "Data.h"
+
+#include "../../Helpers/Assert.h"
+#include "../../Helpers/String/String.h"
+#include "../../Helpers/Vector/Vector.h"
+
+namespace RAPTOR {
+
+// Departure times of the trips of the routes, transposed: for every stop index of a route, the departure times of all its
+// trips are contiguous (a "column"). Since the trips of a route do not overtake each other, a column is sorted, and the
+// earliest trip that can be caught at a stop is found in a single pass over the column, eight trips at a time with AVX2.
+// Only routes with many trips get columns, for the others walking back trip by trip is as fast.
+class DepartureColumns {
+
+public:
+    inline static constexpr size_t BlockSize = 8;
+    inline static constexpr size_t NoColumns = std::numeric_limits<size_t>::max();
+
+public:
+    DepartureColumns(const Data& data, const size_t minNumberOfTrips = 16) :
+        numberOfStopEvents(data.numberOfStopEvents()),
+        implicitBufferTimes(data.hasImplicitBufferTimes()),
+        firstDepartureOfRoute(data.numberOfRoutes(), NoColumns),
+        columnSize(data.numberOfRoutes(), 0) {
+        for (const RouteId route : data.routes()) {
+            const size_t numberOfTrips = data.numberOfTripsInRoute(route);
+            if (numberOfTrips < minNumberOfTrips) continue;
+            const size_t tripSize = data.numberOfStopsInRoute(route);
+            const StopEvent* stopEvents = data.firstTripOfRoute(route);
+            bool isSorted = true;
+            for (size_t trip = 1; trip < numberOfTrips; trip++) {
+                for (size_t i = 0; i < tripSize; i++) {
+                    isSorted &= (stopEvents[((trip - 1) * tripSize) + i].departureTime <= stopEvents[(trip * tripSize) + i].departureTime);
+                }
+            }
+            if (!isSorted) continue;
+            // Columns are padded to full blocks with departure times that can never be caught:
+            columnSize[route] = ((numberOfTrips + BlockSize - 1) / BlockSize) * BlockSize;
+            firstDepartureOfRoute[route] = departures.size();
+            departures.resize(departures.size() + (tripSize * columnSize[route]), std::numeric_limits<int>::max());
+            for (size_t i = 0; i < tripSize; i++) {
+                for (size_t trip = 0; trip < numberOfTrips; trip++) {
+                    departures[firstDepartureOfRoute[route] + (i * columnSize[route]) + trip] = stopEvents[(trip * tripSize) + i].departureTime;
+                }
+            }
+        }
+    }
+
+    inline bool hasColumns(const RouteId route) const noexcept {
+        return firstDepartureOfRoute[route] != NoColumns;
+    }
+
+    // The earliest trip of the route departing at stop index at or after time, if it is earlier than trip (the trip that
+    // is currently used), and trip otherwise.
+    inline size_t earliestTrip(const RouteId route, const StopIndex stopIndex, const int time, const size_t trip) const noexcept {
+        AssertMsg(hasColumns(route), "Route " << route << " has no departure columns!");
+        const int* column = departures.data() + firstDepartureOfRoute[route] + (stopIndex * columnSize[route]);
+        if ((trip == 0) || (column[trip - 1] < time)) return trip;
+        // The column is sorted and column[trip - 1] >= time, hence the number of departures before time is the
+        // earliest trip that can be caught:
+        size_t result = 0;
+#ifdef __AVX2__
+        const __m256i times = _mm256_set1_epi32(time);
+        while (true) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + result));
+            const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(times, block)));
+            if (mask != 0xFF) return result + __builtin_popcount(mask);
+            result += BlockSize;
+        }
+#else
+        while (column[result] < time) result++;
+        return result;
+#endif
+    }
+
+    // The times are copied as they are, hence the copy is only valid while the buffer times of data are in the same state.
+    inline bool isCopyOf(const Data& data) const noexcept {
+        return (firstDepartureOfRoute.size() == data.numberOfRoutes()) && (numberOfStopEvents == data.numberOfStopEvents()) && (implicitBufferTimes == data.hasImplicitBufferTimes());
+    }
+
+    inline size_t numberOfRoutesWithColumns() const noexcept {
+        return std::count_if(firstDepartureOfRoute.begin(), firstDepartureOfRoute.end(), [](const size_t first) {
+            return first != NoColumns;
+        });
+    }
+
+    inline long long byteSize() const noexcept {
+        return Vector::byteSize(firstDepartureOfRoute) + Vector::byteSize(columnSize) + Vector::byteSize(departures);
+    }
+
+    inline void printInfo() const noexcept {
+        std::cout << "Departure columns:" << std::endl;
+        std::cout << "   Routes with columns: " << String::prettyInt(numberOfRoutesWithColumns()) << " / " << String::prettyInt(firstDepartureOfRoute.size()) << std::endl;
+#ifdef __AVX2__
+        std::cout << "   Search:              AVX2" << std::endl;
+#else
+        std::cout << "   Search:              scalar" << std::endl;
+#endif
+        std::cout << "   Memory:              " << String::bytesToString(byteSize()) << std::endl;
+    }
+
+private:
+    size_t numberOfStopEvents;
+    bool implicitBufferTimes;
+
+    std::vector<size_t> firstDepartureOfRoute;
+    std::vector<size_t> columnSize;
+    std::vector<int> departures;
+
+};
+
+}
@@ -0,0 +1,180 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Data.h"
+
+#include "../Graph/Graph.h"
+
+#include "../../Helpers/Assert.h"
+#include "../../Helpers/IO/Serialization.h"
+#include "../../Helpers/String/String.h"
+
+namespace RAPTOR {
+
+// Shortcut graphs computed for departure time windows (e.g. peak, off-peak, night) instead of the whole day. The graph of
+// the window [begin, end] contains the shortcuts of the searches departing between begin and end + horizon (chosen when
+// computing it, and stored with the window), hence a query departing within the window is exact as long as it arrives
+// before end + horizon. Since there are fewer departures per window, these graphs are smaller than the one of the whole
+// day. The windows record the number of stops and stop events of the timetable they were computed for, and a checksum
+// of it.
+class ShortcutWindows {
+
+public:
+    inline static constexpr size_t NoWindow = std::numeric_limits<size_t>::max();
+
+public:
+    ShortcutWindows() :
+        numberOfStops(0),
+        numberOfStopEvents(0),
+        checksum(0) {
+    }
+
+    ShortcutWindows(const Data& data) :
+        numberOfStops(data.numberOfStops()),
+        numberOfStopEvents(data.numberOfStopEvents()),
+        checksum(timetableChecksum(data)) {
+    }
+
+    ShortcutWindows(const std::string& fileName) :
+        numberOfStops(0),
+        numberOfStopEvents(0),
+        checksum(0) {
+        readBinary(fileName);
+    }
+
+    // Reads the windows, which must have been computed for the timetable of data.
+    ShortcutWindows(const std::string& fileName, const Data& data) :
+        ShortcutWindows(fileName) {
+        Ensure(isShortcutWindowsOf(data), "The shortcut windows in " << fileName << " were not computed for this timetable!");
+    }
+
+    inline void addWindow(const int begin, const int end, const int horizon, TransferGraph&& shortcutGraph) noexcept {
+        AssertMsg(begin <= end, "Window [" << begin << ", " << end << "] is empty!");
+        AssertMsg(horizon >= 0, "Horizon " << horizon << " is negative!");
+        AssertMsg(graphs.empty() || graphs.back().numVertices() == shortcutGraph.numVertices(), "Shortcut graphs of all windows must have the same vertices!");
+        begins.emplace_back(begin);
+        ends.emplace_back(end);
+        horizons.emplace_back(horizon);
+        graphs.emplace_back(std::move(shortcutGraph));
+    }
+
+    inline size_t numberOfWindows() const noexcept {
+        return graphs.size();
+    }
+
+    // True if the windows were computed for the timetable of data (up to collisions of the checksum), in particular false
+    // once the stops were renumbered or the timetable was changed.
+    inline bool isShortcutWindowsOf(const Data& data) const noexcept {
+        if (numberOfStops != data.numberOfStops() || numberOfStopEvents != data.numberOfStopEvents()) return false;
+        for (const TransferGraph& graph : graphs) {
+            if (graph.numVertices() != data.transferGraph.numVertices()) return false;
+        }
+        return checksum == timetableChecksum(data);
+    }
+
+    // FNV-1a of the stops of the routes and of the times of the stop events (hence it depends on the implicit buffer
+    // times, which are the same for the computation of the windows and for the queries).
+    inline static uint64_t timetableChecksum(const Data& data) noexcept {
+        uint64_t result = 14695981039346656037ull;
+        for (const StopId stop : data.stopIds) {
+            result = (result ^ uint64_t(stop)) * 1099511628211ull;
+        }
+        for (const StopEvent& stopEvent : data.stopEvents) {
+            result = (result ^ uint64_t(uint32_t(stopEvent.arrivalTime))) * 1099511628211ull;
+            result = (result ^ uint64_t(uint32_t(stopEvent.departureTime))) * 1099511628211ull;
+        }
+        return result;
+    }
+
+    inline int beginOfWindow(const size_t window) const noexcept {
+        return begins[window];
+    }
+
+    inline int endOfWindow(const size_t window) const noexcept {
+        return ends[window];
+    }
+
+    inline int horizonOfWindow(const size_t window) const noexcept {
+        return horizons[window];
+    }
+
+    // The latest arrival time up to which a query departing within the window is exact :
+    inline int validUntil(const size_t window) const noexcept {
+        return ends[window] + horizons[window];
+    }
+
+    inline const TransferGraph& shortcutGraph(const size_t window) const noexcept {
+        return graphs[window];
+    }
+
+    // The window with the fewest shortcuts among those containing [minDepartureTime, maxDepartureTime], NoWindow if
+    // there is none.
+    inline size_t find(const int minDepartureTime, const int maxDepartureTime) const noexcept {
+        size_t result = NoWindow;
+        for (size_t window = 0; window < graphs.size(); window++) {
+            if (begins[window] > minDepartureTime || ends[window] < maxDepartureTime) continue;
+            if (result != NoWindow && graphs[result].numEdges() <= graphs[window].numEdges()) continue;
+            result = window;
+        }
+        return result;
+    }
+
+    inline void writeBinary(const std::string& fileName) const noexcept {
+        IO::serialize(fileName, numberOfStops, numberOfStopEvents, checksum, begins, ends, horizons);
+        for (size_t window = 0; window < graphs.size(); window++) {
+            graphs[window].writeBinary(fileName + ".window" + std::to_string(window));
+        }
+    }
+
+    inline void readBinary(const std::string& fileName) noexcept {
+        IO::deserialize(fileName, numberOfStops, numberOfStopEvents, checksum, begins, ends, horizons);
+        Ensure(begins.size() == ends.size() && begins.size() == horizons.size(), "Shortcut windows in " << fileName << " are inconsistent!");
+        graphs.assign(begins.size(), TransferGraph());
+        for (size_t window = 0; window < graphs.size(); window++) {
+            graphs[window].readBinary(fileName + ".window" + std::to_string(window));
+        }
+    }
+
+    inline void printInfo() const noexcept {
+        for (size_t window = 0; window < graphs.size(); window++) {
+            std::cout << "Window [" << String::secToTime(begins[window]) << ", " << String::secToTime(ends[window]) << "] (exact until " << String::secToTime(validUntil(window)) << "): " << String::prettyInt(graphs[window].numEdges()) << " shortcuts" << std::endl;
+        }
+    }
+
+private:
+    size_t numberOfStops;
+    size_t numberOfStopEvents;
+    uint64_t checksum;
+
+    std::vector<int> begins;
+    std::vector<int> ends;
+    std::vector<int> horizons;
+    std::vector<TransferGraph> graphs;
+
+};
+
+}
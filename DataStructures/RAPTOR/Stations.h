@@ -0,0 +1,200 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+
+#include "Data.h"
+
+#include "../../Helpers/Assert.h"
+#include "../../Helpers/MultiThreading.h"
+#include "../../Helpers/Timer.h"
+#include "../../Helpers/FileSystem/FileSystem.h"
+#include "../../Helpers/IO/Serialization.h"
+#include "../../Helpers/Ranges/SubRange.h"
+#include "../../Helpers/String/String.h"
+#include "../../Helpers/Vector/Vector.h"
+
+namespace RAPTOR {
+
+// The stations of the network: the station of a stop contains all stops that can be reached from it by transfers with a
+// travel time of zero, its representative is the stop of the station with the smallest id. The stops of all stations are
+// stored in a single array (stopsOf(stop) is a range of it), so that the stations can be computed once and shared by all
+// threads searching shortcuts. The stations only depend on the transfers with a travel time of zero of the data they were
+// computed for, a checksum of which is stored with them.
+class Stations {
+
+public:
+    Stations() : checksum(0) {}
+
+    Stations(const Data& data) :
+        checksum(zeroTransfersChecksum(data)),
+        representative(data.numberOfStops(), noStop) {
+        std::vector<std::vector<StopId>> stopsOfStation(data.numberOfStops());
+        Dijkstra<TransferGraph, false> dijkstra(data.transferGraph);
+        for (const StopId stop : data.stops()) {
+            computeStation(data, dijkstra, stop, stopsOfStation[stop]);
+        }
+        buildStopArray(stopsOfStation);
+    }
+
+    // Same as above, but the stations are computed in parallel.
+    Stations(const Data& data, const ThreadPinning& threadPinning) :
+        checksum(zeroTransfersChecksum(data)),
+        representative(data.numberOfStops(), noStop) {
+        std::vector<std::vector<StopId>> stopsOfStation(data.numberOfStops());
+        omp_set_num_threads(threadPinning.numberOfThreads);
+        #pragma omp parallel
+        {
+            threadPinning.pinThread();
+            Dijkstra<TransferGraph, false> dijkstra(data.transferGraph);
+            #pragma omp for schedule(dynamic, 64)
+            for (size_t i = 0; i < data.numberOfStops(); i++) {
+                computeStation(data, dijkstra, StopId(i), stopsOfStation[i]);
+            }
+        }
+        buildStopArray(stopsOfStation);
+    }
+
+    Stations(const std::string& fileName) :
+        checksum(0) {
+        deserialize(fileName);
+    }
+
+    inline static Stations FromBinary(const std::string& fileName) noexcept {
+        return Stations(fileName);
+    }
+
+    // Reads the stations from fileName if they were written for the transfer graph of data, otherwise computes them and
+    // writes them to fileName, so that the next preprocessing of the same network can skip this step.
+    inline static Stations FromBinaryOrCompute(const std::string& fileName, const Data& data, const ThreadPinning& threadPinning, const bool verbose = true) noexcept {
+        if (FileSystem::isFile(fileName)) {
+            Stations stations(fileName);
+            if (stations.isStationsOf(data)) {
+                if (verbose) std::cout << "Read stations from " << fileName << std::endl;
+                return stations;
+            }
+            if (verbose) std::cout << "Stations in " << fileName << " were computed for another network, computing them again." << std::endl;
+        }
+        Timer timer;
+        Stations stations(data, threadPinning);
+        if (verbose) std::cout << "Computed stations in " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
+        stations.serialize(fileName);
+        return stations;
+    }
+
+    inline size_t numberOfStops() const noexcept {
+        return representative.size();
+    }
+
+    // True if the stations were computed for the transfer graph of data (up to collisions of the checksum), in particular
+    // false once the stops were renumbered.
+    inline bool isStationsOf(const Data& data) const noexcept {
+        return (numberOfStops() == data.numberOfStops()) && (checksum == zeroTransfersChecksum(data));
+    }
+
+    // FNV-1a of the transfers with a travel time of zero (the only ones the stations depend on), in the order of the graph.
+    inline static uint64_t zeroTransfersChecksum(const Data& data) noexcept {
+        uint64_t result = 14695981039346656037ull;
+        for (const Vertex from : data.transferGraph.vertices()) {
+            for (const Edge edge : data.transferGraph.edgesFrom(from)) {
+                if (data.transferGraph.get(TravelTime, edge) > 0) continue;
+                result = (result ^ uint64_t(from)) * 1099511628211ull;
+                result = (result ^ uint64_t(data.transferGraph.get(ToVertex, edge))) * 1099511628211ull;
+            }
+        }
+        return result;
+    }
+
+    inline StopId representativeOf(const StopId stop) const noexcept {
+        AssertMsg(stop < numberOfStops(), "Stop " << stop << " is out of range!");
+        return representative[stop];
+    }
+
+    inline bool isRepresentative(const StopId stop) const noexcept {
+        return representativeOf(stop) == stop;
+    }
+
+    // The stops of the station of stop (including stop itself), in the order in which they were reached by the search.
+    inline SubRange<std::vector<StopId>> stopsOf(const StopId stop) const noexcept {
+        AssertMsg(stop < numberOfStops(), "Stop " << stop << " is out of range!");
+        return SubRange<std::vector<StopId>>(stops, firstStopOfStation, stop);
+    }
+
+    inline void serialize(const std::string& fileName) const noexcept {
+        IO::serialize(fileName, checksum, representative, firstStopOfStation, stops);
+    }
+
+    inline void deserialize(const std::string& fileName) noexcept {
+        IO::deserialize(fileName, checksum, representative, firstStopOfStation, stops);
+        Ensure(firstStopOfStation.size() == representative.size() + 1 && firstStopOfStation.back() == stops.size(), "Stations in " << fileName << " are inconsistent!");
+    }
+
+    inline long long byteSize() const noexcept {
+        return Vector::byteSize(representative) + Vector::byteSize(firstStopOfStation) + Vector::byteSize(stops);
+    }
+
+    inline void printInfo() const noexcept {
+        size_t numberOfStations = 0;
+        for (size_t stop = 0; stop < numberOfStops(); stop++) {
+            if (representative[stop] == stop) numberOfStations++;
+        }
+        std::cout << "Stations:" << std::endl;
+        std::cout << "   Number of stations: " << String::prettyInt(numberOfStations) << " / " << String::prettyInt(numberOfStops()) << " stops" << std::endl;
+        std::cout << "   Memory:             " << String::bytesToString(byteSize()) << std::endl;
+    }
+
+private:
+    inline void computeStation(const Data& data, Dijkstra<TransferGraph, false>& dijkstra, const StopId stop, std::vector<StopId>& station) noexcept {
+        dijkstra.run(stop, noVertex, [&](const Vertex u) {
+            if (!data.isStop(u)) return;
+            if (representative[stop] > u) representative[stop] = StopId(u);
+            station.emplace_back(StopId(u));
+        }, NoOperation, [&](const Vertex, const Edge edge) {
+            return data.transferGraph.get(TravelTime, edge) > 0;
+        });
+    }
+
+    inline void buildStopArray(const std::vector<std::vector<StopId>>& stopsOfStation) noexcept {
+        firstStopOfStation.assign(stopsOfStation.size() + 1, 0);
+        for (size_t stop = 0; stop < stopsOfStation.size(); stop++) {
+            firstStopOfStation[stop + 1] = firstStopOfStation[stop] + stopsOfStation[stop].size();
+        }
+        stops.reserve(firstStopOfStation.back());
+        for (const std::vector<StopId>& station : stopsOfStation) {
+            stops.insert(stops.end(), station.begin(), station.end());
+        }
+    }
+
+private:
+    uint64_t checksum;
+    std::vector<StopId> representative;
+    std::vector<size_t> firstStopOfStation;
+    std::vector<StopId> stops;
+
+};
+
+}
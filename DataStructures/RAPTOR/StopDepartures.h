@@ -0,0 +1,122 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "Data.h"
+#include "Entities/RouteSegment.h"
+
+#include "../../Helpers/Assert.h"
+#include "../../Helpers/String/String.h"
+#include "../../Helpers/Vector/Vector.h"
+
+namespace RAPTOR {
+
+// The departure events of every stop, sorted by departure time, together with the route segment they belong to. This
+// allows finding the departures of a stop within a time window by a binary search, without looking at the other routes
+// and trips of the network. The last stop of a route has no departures.
+class StopDepartures {
+
+public:
+    struct Departure {
+        Departure(const int departureTime = never, const RouteSegment& route = RouteSegment()) :
+            departureTime(departureTime),
+            route(route) {
+        }
+        inline bool operator<(const Departure& other) const noexcept {
+            return (departureTime < other.departureTime) || ((departureTime == other.departureTime) && ((route.routeId < other.route.routeId) || ((route.routeId == other.route.routeId) && (route.stopIndex < other.route.stopIndex))));
+        }
+        int departureTime;
+        RouteSegment route;
+    };
+
+public:
+    StopDepartures(const Data& data) :
+        numberOfStopEvents(data.numberOfStopEvents()),
+        implicitBufferTimes(data.hasImplicitBufferTimes()),
+        firstDepartureOfStop(data.numberOfStops() + 1, 0) {
+        for (const RouteId route : data.routes()) {
+            const StopId* stops = data.stopArrayOfRoute(route);
+            const size_t tripSize = data.numberOfStopsInRoute(route);
+            for (size_t stopIndex = 0; stopIndex + 1 < tripSize; stopIndex++) {
+                firstDepartureOfStop[stops[stopIndex] + 1] += data.numberOfTripsInRoute(route);
+            }
+        }
+        for (size_t stop = 0; stop < data.numberOfStops(); stop++) {
+            firstDepartureOfStop[stop + 1] += firstDepartureOfStop[stop];
+        }
+        departures.resize(firstDepartureOfStop.back());
+        std::vector<size_t> nextDepartureOfStop(firstDepartureOfStop.begin(), firstDepartureOfStop.end() - 1);
+        for (const RouteId route : data.routes()) {
+            const StopId* stops = data.stopArrayOfRoute(route);
+            const size_t tripSize = data.numberOfStopsInRoute(route);
+            for (const StopEvent* trip = data.firstTripOfRoute(route); trip <= data.lastTripOfRoute(route); trip += tripSize) {
+                for (size_t stopIndex = 0; stopIndex + 1 < tripSize; stopIndex++) {
+                    departures[nextDepartureOfStop[stops[stopIndex]]++] = Departure(trip[stopIndex].departureTime, RouteSegment(route, StopIndex(stopIndex)));
+                }
+            }
+        }
+        for (size_t stop = 0; stop < data.numberOfStops(); stop++) {
+            std::sort(departures.begin() + firstDepartureOfStop[stop], departures.begin() + firstDepartureOfStop[stop + 1]);
+        }
+    }
+
+    // The departures of stop, sorted by departure time: [beginOf(stop), endOf(stop)).
+    inline const Departure* beginOf(const StopId stop) const noexcept {
+        AssertMsg(stop + 1 < firstDepartureOfStop.size(), "Stop " << stop << " is out of range!");
+        return departures.data() + firstDepartureOfStop[stop];
+    }
+
+    inline const Departure* endOf(const StopId stop) const noexcept {
+        AssertMsg(stop + 1 < firstDepartureOfStop.size(), "Stop " << stop << " is out of range!");
+        return departures.data() + firstDepartureOfStop[stop + 1];
+    }
+
+    inline size_t numberOfDepartures() const noexcept {
+        return departures.size();
+    }
+
+    inline bool isDeparturesOf(const Data& data) const noexcept {
+        return (firstDepartureOfStop.size() == data.numberOfStops() + 1) && (numberOfStopEvents == data.numberOfStopEvents()) && (implicitBufferTimes == data.hasImplicitBufferTimes());
+    }
+
+    inline long long byteSize() const noexcept {
+        return Vector::byteSize(firstDepartureOfStop) + Vector::byteSize(departures);
+    }
+
+    inline void printInfo() const noexcept {
+        std::cout << "Stop departures:" << std::endl;
+        std::cout << "   Number of departures: " << String::prettyInt(numberOfDepartures()) << std::endl;
+        std::cout << "   Memory:               " << String::bytesToString(byteSize()) << std::endl;
+    }
+
+private:
+    size_t numberOfStopEvents;
+    bool implicitBufferTimes;
+    std::vector<size_t> firstDepartureOfStop;
+    std::vector<Departure> departures;
+
+};
+
+}
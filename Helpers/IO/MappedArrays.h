@@ -0,0 +1,241 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Serialization.h"
+
+#include "../Assert.h"
+#include "../Meta.h"
+#include "../FileSystem/FileSystem.h"
+
+namespace IO {
+
+    //############################################# Memory Mapped File ################################################################//
+    // Read-only view of a whole file. The mapping is shared, hence several processes mapping the same file use the same page cache.
+    class MemoryMappedFile {
+
+    public:
+        MemoryMappedFile(const std::string& fileName) :
+            fileName(fileName),
+            begin(nullptr),
+            size(0) {
+            const int fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+            Ensure(fileDescriptor >= 0, "cannot open file: " << fileName);
+            struct stat fileStatus;
+            Ensure(::fstat(fileDescriptor, &fileStatus) == 0, "cannot stat file: " << fileName);
+            size = fileStatus.st_size;
+            if (size > 0) {
+                void* address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+                Ensure(address != MAP_FAILED, "cannot map file: " << fileName);
+                begin = static_cast<const char*>(address);
+            }
+            ::close(fileDescriptor);
+        }
+
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+        ~MemoryMappedFile() {
+            if (begin != nullptr) ::munmap(const_cast<char*>(begin), size);
+        }
+
+        inline const char* data() const noexcept {
+            return begin;
+        }
+
+        inline size_t byteSize() const noexcept {
+            return size;
+        }
+
+        inline const std::string& getFileName() const noexcept {
+            return fileName;
+        }
+
+    private:
+        const std::string fileName;
+        const char* begin;
+        size_t size;
+
+    };
+
+    //############################################# Mapped Array Layout ###############################################################//
+    // File layout: header, table of arrays, followed by the raw arrays. Every array starts at a multiple of ArrayAlignment, hence
+    // arrays are cache line aligned once the file is mapped (mmap returns page aligned addresses).
+    namespace ImplementationDetail {
+        inline constexpr char MappedArraysMagic[8] = {'U', 'L', 'T', 'R', 'A', 'M', 'A', 'P'};
+        inline constexpr size_t ArrayAlignment = 64;
+
+        struct MappedArraysHeader {
+            char magic[8];
+            uint64_t version;
+            uint64_t numberOfArrays;
+            uint64_t unused;
+        };
+
+        struct MappedArrayInfo {
+            char name[32];
+            char type[64];
+            uint64_t elementSize;
+            uint64_t size;
+            uint64_t offset;
+            uint64_t unused;
+        };
+
+        inline uint64_t alignOffset(const uint64_t offset) noexcept {
+            return ((offset + ArrayAlignment - 1) / ArrayAlignment) * ArrayAlignment;
+        }
+
+        inline void copyName(char* destination, const size_t capacity, const std::string& name) noexcept {
+            std::memset(destination, 0, capacity);
+            std::memcpy(destination, name.data(), std::min(name.size(), capacity - 1));
+        }
+
+        inline bool equalsName(const char* stored, const size_t capacity, const std::string& name) noexcept {
+            return std::strncmp(stored, name.substr(0, capacity - 1).c_str(), capacity) == 0;
+        }
+    }
+
+    class MappedArraysWriter {
+
+    private:
+        struct Array {
+            std::string name;
+            std::string type;
+            size_t elementSize;
+            size_t size;
+            const char* data;
+        };
+
+    public:
+        MappedArraysWriter(const std::string& fileName, const size_t version) :
+            fileName(fileName),
+            version(version) {
+        }
+
+        template<typename T>
+        inline void add(const std::string& name, const T* data, const size_t size) noexcept {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be mapped!");
+            AssertMsg(name.size() < sizeof(ImplementationDetail::MappedArrayInfo::name), "Array name " << name << " is too long!");
+            arrays.emplace_back(Array{name, Meta::type<T>(), sizeof(T), size, reinterpret_cast<const char*>(data)});
+        }
+
+        template<typename T>
+        inline void add(const std::string& name, const std::vector<T>& vector) noexcept {
+            add(name, vector.data(), vector.size());
+        }
+
+        inline void write() const noexcept {
+            std::ofstream os(FileSystem::ensureDirectoryExists(fileName), std::ios::binary);
+            checkStream(os, fileName);
+            ImplementationDetail::MappedArraysHeader header;
+            std::memcpy(header.magic, ImplementationDetail::MappedArraysMagic, sizeof(header.magic));
+            header.version = version;
+            header.numberOfArrays = arrays.size();
+            header.unused = 0;
+            os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            uint64_t offset = ImplementationDetail::alignOffset(sizeof(header) + arrays.size() * sizeof(ImplementationDetail::MappedArrayInfo));
+            for (const Array& array : arrays) {
+                ImplementationDetail::MappedArrayInfo info;
+                ImplementationDetail::copyName(info.name, sizeof(info.name), array.name);
+                ImplementationDetail::copyName(info.type, sizeof(info.type), array.type);
+                info.elementSize = array.elementSize;
+                info.size = array.size;
+                info.offset = offset;
+                info.unused = 0;
+                os.write(reinterpret_cast<const char*>(&info), sizeof(info));
+                offset = ImplementationDetail::alignOffset(offset + array.size * array.elementSize);
+            }
+            const std::vector<char> padding(ImplementationDetail::ArrayAlignment, 0);
+            for (const Array& array : arrays) {
+                const uint64_t position = os.tellp();
+                os.write(padding.data(), ImplementationDetail::alignOffset(position) - position);
+                os.write(array.data, array.size * array.elementSize);
+            }
+            Ensure(os.good(), "error while writing file: " << fileName);
+        }
+
+    private:
+        const std::string fileName;
+        const size_t version;
+        std::vector<Array> arrays;
+
+    };
+
+    class MappedArrays {
+
+    public:
+        MappedArrays(const std::string& fileName, const size_t expectedVersion) :
+            file(std::make_shared<const MemoryMappedFile>(fileName)) {
+            Ensure(file->byteSize() >= sizeof(ImplementationDetail::MappedArraysHeader), "File " << fileName << " is too small to contain mapped arrays!");
+            const ImplementationDetail::MappedArraysHeader& header = *reinterpret_cast<const ImplementationDetail::MappedArraysHeader*>(file->data());
+            Ensure(std::memcmp(header.magic, ImplementationDetail::MappedArraysMagic, sizeof(header.magic)) == 0, "No mapped arrays header found, cannot read the file: " << fileName);
+            Ensure(header.version == expectedVersion, "Expected version " << expectedVersion << ", but file " << fileName << " has version " << header.version);
+            Ensure(sizeof(header) + header.numberOfArrays * sizeof(ImplementationDetail::MappedArrayInfo) <= file->byteSize(), "File " << fileName << " is truncated!");
+            infos = reinterpret_cast<const ImplementationDetail::MappedArrayInfo*>(file->data() + sizeof(header));
+            numberOfArrays = header.numberOfArrays;
+        }
+
+        template<typename T>
+        inline const T* get(const std::string& name, size_t& size) const noexcept {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be mapped!");
+            const ImplementationDetail::MappedArrayInfo& info = find(name);
+            Ensure(ImplementationDetail::equalsName(info.type, sizeof(info.type), Meta::type<T>()), "Trying to map an array of " << Meta::type<T>() << " from an array of " << info.type << "!");
+            Ensure(info.elementSize == sizeof(T), "Array " << name << " has elements of size " << info.elementSize << ", but " << sizeof(T) << " was expected!");
+            Ensure(info.offset % alignof(T) == 0, "Array " << name << " is not properly aligned!");
+            Ensure(info.offset + info.size * info.elementSize <= file->byteSize(), "File " << file->getFileName() << " is truncated!");
+            size = info.size;
+            return reinterpret_cast<const T*>(file->data() + info.offset);
+        }
+
+        inline const std::shared_ptr<const MemoryMappedFile>& getFile() const noexcept {
+            return file;
+        }
+
+    private:
+        inline const ImplementationDetail::MappedArrayInfo& find(const std::string& name) const noexcept {
+            for (size_t i = 0; i < numberOfArrays; i++) {
+                if (ImplementationDetail::equalsName(infos[i].name, sizeof(infos[i].name), name)) return infos[i];
+            }
+            Ensure(false, "File " << file->getFileName() << " contains no array named " << name << "!");
+            return infos[0];
+        }
+
+    private:
+        std::shared_ptr<const MemoryMappedFile> file;
+        const ImplementationDetail::MappedArrayInfo* infos;
+        size_t numberOfArrays;
+
+    };
+
+}
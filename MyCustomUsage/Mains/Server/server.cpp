@@ -1,6 +1,10 @@
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include <httplib.h>
 
@@ -10,44 +14,164 @@
 #include "Server/Snapping/snapping.h"
 #include "Server/Handlers/echo_handler.h"
 #include "Server/Handlers/journey_handler.h"
+#include "Server/Handlers/metrics_handler.h"
+#include "Server/metrics.h"
+#include "Server/stop_ids.h"
 
 using std::cout;
 using std::endl;
 
+// a range request runs one search per departure time, hence its cost grows with the range :
+constexpr int DEFAULT_MAX_RANGE_WINDOW = 3 * 3600;
+
 inline void usage() noexcept {
-    std::cout << "Usage: ultra-server  <port>  <RAPTOR binary>  <bucketCH-basename>\n";
+    std::cout << "Usage: ultra-server  [<options>]  <port>  <RAPTOR binary>  <bucketCH-basename>  [<nb workers>]\n";
+    std::cout << "\n";
+    std::cout << "nb workers = number of requests processed concurrently (defaults to the number of cores)\n";
+    std::cout << "\n";
+    std::cout << "options :\n";
+    std::cout << "    --compact-stop-events   scan the routes using 16-bit offsets (a copy of the stop events, built at startup)\n";
+    std::cout << "    --departure-columns     search the trips of busy routes in transposed departure times (built at startup,\n";
+    std::cout << "                            about half the size of the stop events)\n";
+    std::cout << "    --max-range-window=<s>  maximum range (in seconds) of a /range_between_locations request (default "
+              << DEFAULT_MAX_RANGE_WINDOW << ")\n";
     std::cout << "\n";
     std::cout << "This is a BLOCKING server -> do NOT use in anything remotely close to production !\n";
     std::cout << std::endl;
     exit(0);
 }
 
-using ShortcutRAPTOR = RAPTOR::ULTRARAPTOR<RAPTOR::NoDebugger>;
+using ShortcutRAPTOR = RAPTOR::ULTRARAPTOR<RAPTOR::CountersDebugger>;
 
 int main(int argc, char** argv) {
-    if (argc < 4)
+    // the options (which all begin with "--") may appear anywhere, the other arguments are positional :
+    std::vector<std::string> args;
+    bool useCompactStopEvents = false;
+    bool useDepartureColumns = false;
+    int maxRangeWindow = DEFAULT_MAX_RANGE_WINDOW;
+    std::string const maxRangeWindowOption = "--max-range-window=";
+    for (int i = 1; i < argc; ++i) {
+        std::string const arg = argv[i];
+        if (arg == "--compact-stop-events") {
+            useCompactStopEvents = true;
+        } else if (arg == "--departure-columns") {
+            useDepartureColumns = true;
+        } else if (arg.rfind(maxRangeWindowOption, 0) == 0) {
+            try {
+                maxRangeWindow = std::stoi(arg.substr(maxRangeWindowOption.size()));
+            } catch (...) {
+                std::cerr << "ERROR : unable to parse max range window '" << arg << "'" << std::endl;
+                usage();
+            }
+            if (maxRangeWindow < 0) {
+                std::cerr << "ERROR : max range window must not be negative" << std::endl;
+                usage();
+            }
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "ERROR : unknown option '" << arg << "'" << std::endl;
+            usage();
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.size() < 3)
         usage();
     int port = 0;
     try {
-        port = std::stoi(argv[1]);
+        port = std::stoi(args[0]);
     } catch (...) {
-        std::cerr << "ERROR : unable to parse port '" << argv[1] << "'" << std::endl;
+        std::cerr << "ERROR : unable to parse port '" << args[0] << "'" << std::endl;
         usage();
         exit(1);
     }
     std::cerr << "Listening to port " << port << std::endl;
-    const std::string raptorFile = argv[2];
-    const std::string bucketChBasename = argv[3];
+    const std::string raptorFile = args[1];
+    const std::string bucketChBasename = args[2];
+    size_t nbWorkers = std::max(1u, std::thread::hardware_concurrency());
+    if (args.size() > 3) {
+        try {
+            nbWorkers = std::stoul(args[3]);
+        } catch (...) {
+            std::cerr << "ERROR : unable to parse nb workers '" << args[3] << "'" << std::endl;
+            usage();
+        }
+        if (nbWorkers == 0) {
+            std::cerr << "ERROR : nb workers must be positive" << std::endl;
+            usage();
+        }
+    }
 
     std::cout << "raptorFile            = " << raptorFile << std::endl;
     std::cout << "bucketChBasename      = " << bucketChBasename << std::endl;
+    std::cout << "nbWorkers             = " << nbWorkers << std::endl;
+    std::cout << "maxRangeWindow        = " << maxRangeWindow << std::endl;
 
-    RAPTOR::Data data = RAPTOR::Data::FromBinary(raptorFile);
+    // if ComputeShortcuts wrote the mappable variant of the data, its flat arrays are used in place (no copy, and the page
+    // cache is shared between several servers running on the same host) ; it must have been written for raptorFile (whose
+    // checksum, written next to it in raptorFile.checksum, it records) :
+    std::string const mappedRaptorFile = raptorFile + ".mapped";
+    bool const useMappedData = std::filesystem::is_regular_file(mappedRaptorFile);
+    std::cout << "mappedRaptorFile      = " << (useMappedData ? mappedRaptorFile : "(none)") << std::endl;
+    RAPTOR::Data data =
+        useMappedData ? RAPTOR::Data::FromMappedBinary(mappedRaptorFile, raptorFile) : RAPTOR::Data::FromBinary(raptorFile);
     data.useImplicitDepartureBufferTimes();
     data.printInfo();
 
     CH::CH bucketCH(bucketChBasename);
-    ShortcutRAPTOR algorithm(data, bucketCH);
+
+    // the bucket graphs are precomputed by STEP2 (BuildBucketGraphs) ; if they are missing, they are built once here.
+    // Precomputed ones must have been built for bucketCH and the stops of data (which is checked while reading them) :
+    std::string const bucketGraphsFile = bucketChBasename + ".buckets";
+    bool const hasBucketGraphs = std::filesystem::is_regular_file(bucketGraphsFile);
+    std::cout << "bucketGraphsFile      = " << (hasBucketGraphs ? bucketGraphsFile : "(none)") << std::endl;
+    auto const bucketGraphs = std::make_shared<CH::BucketGraphs const>(
+        hasBucketGraphs ? CH::BucketGraphs(bucketGraphsFile, bucketCH, data.numberOfStops())
+                        : CH::BucketQuery<>::BuildBucketGraphs(bucketCH, data.numberOfStops(), nbWorkers));
+
+    // if ComputeShortcutWindows wrote shortcut graphs for departure time windows, a query uses the smallest graph of a
+    // window containing its departure time (and falls back to the shortcuts of the whole day otherwise). They must have
+    // been computed for the timetable of data (which is checked while reading them) :
+    std::string const shortcutWindowsFile = raptorFile + ".windows";
+    bool const hasShortcutWindows = std::filesystem::is_regular_file(shortcutWindowsFile);
+    std::cout << "shortcutWindowsFile   = " << (hasShortcutWindows ? shortcutWindowsFile : "(none)") << std::endl;
+    std::shared_ptr<RAPTOR::ShortcutWindows const> shortcutWindows;
+    if (hasShortcutWindows) {
+        shortcutWindows = std::make_shared<RAPTOR::ShortcutWindows const>(shortcutWindowsFile, data);
+        shortcutWindows->printInfo();
+    }
+
+    // on demand, the routes are scanned using 16-bit offsets from a base time per trip (half the memory of the stop
+    // events) ; since they are a copy built at startup, they cost memory on top of the (possibly mapped) data :
+    std::cout << "useCompactStopEvents  = " << (useCompactStopEvents ? "yes" : "no") << std::endl;
+    std::shared_ptr<RAPTOR::CompactStopEvents const> compactStopEvents;
+    if (useCompactStopEvents) {
+        compactStopEvents = std::make_shared<RAPTOR::CompactStopEvents const>(data);
+        compactStopEvents->printInfo();
+    }
+
+    // on demand, the earliest trip that can be caught on routes with many trips is searched in transposed departure
+    // times ; they are also built at startup (4 bytes per departure of these routes, i.e. about half their stop events) :
+    std::cout << "useDepartureColumns   = " << (useDepartureColumns ? "yes" : "no") << std::endl;
+    std::shared_ptr<RAPTOR::DepartureColumns const> departureColumns;
+    if (useDepartureColumns) {
+        departureColumns = std::make_shared<RAPTOR::DepartureColumns const>(data);
+        departureColumns->printInfo();
+    }
+
+    // each worker gets its own engine (with its own query state), but they all share data, bucketCH, bucketGraphs,
+    // shortcutWindows, compactStopEvents and departureColumns :
+    std::cout << "Building " << nbWorkers << " query engines" << std::endl;
+    myserver::UltraEnginePool engines(nbWorkers, [&data, &bucketCH, &bucketGraphs, &shortcutWindows, &compactStopEvents,
+                                                  &departureColumns]() {
+        auto engine = std::make_unique<ShortcutRAPTOR>(data, bucketCH, bucketGraphs);
+        if (compactStopEvents)
+            engine->useCompactStopEvents(compactStopEvents);
+        if (departureColumns)
+            engine->useDepartureColumns(departureColumns);
+        if (shortcutWindows)
+            engine->useShortcutWindows(shortcutWindows);
+        return engine;
+    });
 
     // ideally, we'd like to have a stopmap with detailed stop infos (name, id, ...)
     // for now, we build a stopmap from the transferGraph, which has very few infos on stops :
@@ -55,38 +179,76 @@ int main(int argc, char** argv) {
     // EDIT : actually, we can get at least the name from raptorData.
     auto numStops = data.numberOfStops();
     std::cout << "How many stops in the transferGraph : " << numStops << std::endl;
+
+    // if ReorderStops renumbered the stops, the ids exposed by the server are still their ranks in the GTFS data :
+    std::string const stopPermutationFile = raptorFile + ".stopPermutation";
+    bool const hasStopPermutation = std::filesystem::is_regular_file(stopPermutationFile);
+    std::cout << "stopPermutationFile   = " << (hasStopPermutation ? stopPermutationFile : "(none)") << std::endl;
+    myserver::StopIds const stopIds =
+        hasStopPermutation ? myserver::StopIds(Permutation(stopPermutationFile)) : myserver::StopIds(numStops);
+    if (stopIds.size() != numStops) {
+        std::cerr << "ERROR : " << stopPermutationFile << " does not match the stops of " << raptorFile << std::endl;
+        return 1;
+    }
+
     myserver::StopMap coarse_stopmap;
+    std::vector<Geometry::Point> stopCoordinates;
     for (int stopRank = 0; stopRank < numStops; ++stopRank) {
         Geometry::Point coords = data.transferGraph.get(Coordinates, Vertex(stopRank));
+        stopCoordinates.push_back(coords);
 
-        // as we have no further info on stops in ULTRA data, for now, id and name are identical to the rank :
-        std::string id = std::to_string(stopRank);
+        // as we have no further info on stops in ULTRA data, for now, the id is the rank in the GTFS data :
+        std::string id = stopIds.to_external(Vertex(stopRank));
         std::string name = data.stopData[stopRank].name;
         coarse_stopmap.emplace(make_pair(id, myserver::Stop{id, name, coords.longitude, coords.latitude}));
     }
     std::cout << std::endl;
-    myserver::build_index(coarse_stopmap);
+
+    // a location is snapped to the stops around it, which are all used as sources (or targets) of the query ; as for
+    // the engines, each worker gets its own tree, so that the location queries run concurrently :
+    myserver::Snapper const snapper(stopCoordinates, nbWorkers);
 
     std::cout << "How many stops in the coarse stopmap : " << coarse_stopmap.size() << std::endl;
     std::cout << std::endl;
 
+    // per-phase latencies and work of the queries, aggregated over all the workers :
+    myserver::Metrics metrics;
+
     httplib::Server svr;
 
+    // as many http workers as engines, so that a worker never waits for an engine :
+    svr.new_task_queue = [nbWorkers] { return new httplib::ThreadPool(nbWorkers); };
+
     // echo :
     svr.Get("/echo", myserver::handle_echo);
 
+    // performance counters (Prometheus text format) :
+    auto f0 = [&metrics](const httplib::Request& req, httplib::Response& res) {
+        myserver::handle_metrics(req, res, metrics);
+    };
+    svr.Get("/metrics", f0);
+
     // journey between stops :
-    auto f1 = [&algorithm, &coarse_stopmap](const httplib::Request& req, httplib::Response& res) {
-        myserver::handle_journey_between_stops(req, res, algorithm, coarse_stopmap);
+    auto f1 = [&engines, &coarse_stopmap, &stopIds, &metrics](const httplib::Request& req, httplib::Response& res) {
+        myserver::handle_journey_between_stops(req, res, engines, coarse_stopmap, stopIds, metrics);
     };
     svr.Get("/journey_between_stops", f1);
 
     // journey between locations :
-    auto f2 = [&algorithm, &coarse_stopmap](const httplib::Request& req, httplib::Response& res) {
-        myserver::handle_journey_between_locations(req, res, algorithm, coarse_stopmap);
+    auto f2 = [&engines, &coarse_stopmap, &stopIds, &snapper, &metrics](const httplib::Request& req,
+                                                                         httplib::Response& res) {
+        myserver::handle_journey_between_locations(req, res, engines, coarse_stopmap, stopIds, snapper, metrics);
     };
     svr.Get("/journey_between_locations", f2);
 
+    // all the journeys between locations, departing in a time range :
+    auto f3 = [&engines, &coarse_stopmap, &stopIds, &snapper, &metrics, maxRangeWindow](const httplib::Request& req,
+                                                                                         httplib::Response& res) {
+        myserver::handle_range_between_locations(req, res, engines, coarse_stopmap, stopIds, snapper, metrics,
+                                                 maxRangeWindow);
+    };
+    svr.Get("/range_between_locations", f3);
+
     std::filesystem::path program_path{argv[0]};
     // Serving a viewer (this depends on a suitable organization of the folders in the repo) :
     auto src_path = program_path.parent_path().parent_path().parent_path();
@@ -15,8 +15,6 @@
 
 using namespace std;
 
-using ALGO = RAPTOR::ULTRARAPTOR<RAPTOR::NoDebugger>;
-
 namespace myserver {
 
 struct UnknownStation : public std::exception {
@@ -25,6 +23,27 @@ struct UnknownStation : public std::exception {
     inline const char* what() const throw() { return msg.c_str(); }
 };
 
+// a stop from which the journey can start (or at which it can end), and the walk between it and the location :
+struct AccessParam {
+    string id;
+    float distance_meters;
+    int walking_time;
+    rapidjson::Value as_json(rapidjson::Document::AllocatorType& a) const {
+        rapidjson::Value access(rapidjson::kObjectType);
+        access.AddMember("id", rapidjson::Value().SetString(id.c_str(), a), a);
+        access.AddMember("distance", rapidjson::Value(distance_meters), a);
+        access.AddMember("walking_time", rapidjson::Value(walking_time), a);
+        return access;
+    }
+};
+
+rapidjson::Value accesses_to_json(vector<AccessParam> const& accesses, rapidjson::Document::AllocatorType& a) {
+    rapidjson::Value json(rapidjson::kArrayType);
+    for (auto& access : accesses)
+        json.PushBack(access.as_json(a), a);
+    return json;
+}
+
 struct JourneyParams {
     JourneyParams() = default;
     JourneyParams(string srcid_,
@@ -37,7 +56,9 @@ struct JourneyParams {
                   double dstlon_,
                   double dstlat_,
                   float dst_snap_distance_,
-                  int departure_time_)
+                  int departure_time_,
+                  vector<AccessParam> src_accesses_ = {},
+                  vector<AccessParam> dst_accesses_ = {})
         : srcid{srcid_},
           srcname{srcname_},
           srclon{srclon_},
@@ -48,7 +69,9 @@ struct JourneyParams {
           dstlon{dstlon_},
           dstlat{dstlat_},
           dst_snap_distance{dst_snap_distance_},
-          departure_time{departure_time_} {}
+          departure_time{departure_time_},
+          src_accesses{src_accesses_},
+          dst_accesses{dst_accesses_} {}
     rapidjson::Value as_json(rapidjson::Document::AllocatorType& a) const {
         rapidjson::Value params(rapidjson::kObjectType);
         params.AddMember("srcid", rapidjson::Value().SetString(srcid.c_str(), a), a);
@@ -64,6 +87,8 @@ struct JourneyParams {
         params.AddMember("departure_time", rapidjson::Value(departure_time), a);
         params.AddMember("departure_time_str", rapidjson::Value().SetString(my::format_time(departure_time).c_str(), a),
                          a);
+        params.AddMember("src_accesses", accesses_to_json(src_accesses, a), a);
+        params.AddMember("dst_accesses", accesses_to_json(dst_accesses, a), a);
         return params;
     }
     string srcid, srcname;
@@ -73,6 +98,11 @@ struct JourneyParams {
     double dstlon, dstlat;
     float dst_snap_distance;
     int departure_time;
+
+    // when the source (or target) is a location, the journeys can start (or end) at any of the stops around it ; the
+    // srcid (or dstid) is then the closest one :
+    vector<AccessParam> src_accesses;
+    vector<AccessParam> dst_accesses;
 };
 
 // it is forbidden to provide more than one value for a needed param :
@@ -149,31 +179,54 @@ pair<double, double> parse_location(string const& location_str) {
     return {longitude, latitude};
 }
 
-JourneyParams parse_locations_params(const httplib::Params& params, myserver::StopMap const& stops) {
+vector<AccessParam> snap_location(string const& location_str,
+                                  Snapper const& snapper,
+                                  myserver::StopIds const& stop_ids) {
+    auto location = parse_location(location_str);
+    vector<AccessParam> accesses;
+    for (auto& snapped : snapper.snap(location.first, location.second))
+        accesses.push_back({stop_ids.to_external(snapped.stop), snapped.distance_meters, snapped.walking_time});
+    return accesses;
+}
+
+JourneyParams parse_locations_params(const httplib::Params& params,
+                                     myserver::StopMap const& stops,
+                                     myserver::StopIds const& stop_ids,
+                                     Snapper const& snapper) {
     // other params are ignored
 
     string src = get_required_param_as_string(params, "src");
-    auto src_pair = parse_location(src);
-    auto src_result = get_closest_stop(src_pair.first, src_pair.second);
-    auto src_id = get<0>(src_result);
-    auto src_name = stopid_to_stopname(src_id, stops, "unknown-name");
-    auto src_lon = get<1>(src_result);
-    auto src_lat = get<2>(src_result);
-    auto src_snap_distance = get<3>(src_result);
+    auto src_accesses = snap_location(src, snapper, stop_ids);
+    // the snapper always returns at least one stop, the closest one being the first :
+    auto const& src_stop = stops.at(src_accesses.front().id);
 
     string dst = get_required_param_as_string(params, "dst");
-    auto dst_pair = parse_location(dst);
-    auto dst_result = get_closest_stop(dst_pair.first, dst_pair.second);
-    auto dst_id = get<0>(dst_result);
-    auto dst_name = stopid_to_stopname(dst_id, stops, "unknown-name");
-    auto dst_lon = get<1>(dst_result);
-    auto dst_lat = get<2>(dst_result);
-    auto dst_snap_distance = get<3>(dst_result);
+    auto dst_accesses = snap_location(dst, snapper, stop_ids);
+    auto const& dst_stop = stops.at(dst_accesses.front().id);
 
     int departure_time = get_required_param_as_int(params, "departure-time");
 
-    return {src_id,   src_name, src_lon, src_lat,           src_snap_distance, dst_id,
-            dst_name, dst_lon,  dst_lat, dst_snap_distance, departure_time};
+    return {src_stop.id,
+            src_stop.name,
+            src_stop.lon,
+            src_stop.lat,
+            src_accesses.front().distance_meters,
+            dst_stop.id,
+            dst_stop.name,
+            dst_stop.lon,
+            dst_stop.lat,
+            dst_accesses.front().distance_meters,
+            departure_time,
+            src_accesses,
+            dst_accesses};
+}
+
+// the accesses refer to the ids exposed by the server, the engines use their own ids (see StopIds) :
+vector<RAPTOR::AccessStop> to_access_stops(vector<AccessParam> const& accesses, myserver::StopIds const& stop_ids) {
+    vector<RAPTOR::AccessStop> access_stops;
+    for (auto& access : accesses)
+        access_stops.push_back({stop_ids.to_internal(access.id), access.walking_time});
+    return access_stops;
 }
 
 rapidjson::Document prepare_response(const httplib::Request& req, httplib::Response& res) {
@@ -214,33 +267,47 @@ void finalize_response(httplib::Response& res, rapidjson::Document& doc, int htt
 bool compute_journey(JourneyParams const& jparams,
                      rapidjson::Value& response_field,
                      rapidjson::Document::AllocatorType& a,
-                     ALGO& algo,
-                     myserver::StopMap const& stops) {
+                     UltraEnginePool& engines,
+                     myserver::StopMap const& stops,
+                     myserver::StopIds const& stop_ids,
+                     myserver::Metrics& metrics) {
     response_field.AddMember("journey_params", jparams.as_json(a), a);
 
     decltype(chrono::high_resolution_clock::now()) before;
     int eat = -1;
 
     vector<myserver::Leg> legs;
+    vector<myserver::ParetoJourney> pareto_journeys;
     string printed_journey;
     bool is_raptor_ok = false;
     float walkspeed_km_per_hour = 9999;
     string raptor_error_msg = "";
     try {
+        // the ids are the ranks of the stops in the GTFS data, the engines may use other ids (see StopIds) :
+        Vertex SOURCE = stop_ids.to_internal(jparams.srcid);
+        Vertex TARGET = stop_ids.to_internal(jparams.dstid);
+        auto const sources = to_access_stops(jparams.src_accesses, stop_ids);
+        auto const targets = to_access_stops(jparams.dst_accesses, stop_ids);
+
+        // the engine is only held during the computation (not during the json serialization) :
+        auto engine = engines.acquire();
         before = chrono::high_resolution_clock::now();
-
-        // for now, the ids are the rank -> we can convert them directly :
-        int SOURCE = std::stoi(jparams.srcid);
-        int TARGET = std::stoi(jparams.dstid);
-        legs = algo.run(Vertex(SOURCE), jparams.departure_time, Vertex(TARGET));
-
-        // STUBS :
-        if (!legs.empty()) {
-            auto last_leg = legs.back();
-            eat = last_leg.arrival_time;
+        // a location is snapped to several stops, that are all used as sources (or targets) of a single search :
+        if (sources.empty() || targets.empty())
+            pareto_journeys = engine->runPareto(SOURCE, jparams.departure_time, TARGET);
+        else
+            pareto_journeys = engine->runPareto(sources, jparams.departure_time, targets);
+        metrics.journey.record(engine->getDebugger());
+        for (auto& journey : pareto_journeys)
+            stop_ids.to_external(journey.legs);
+
+        // the earliest arrival journey is the pareto journey with the most trips :
+        if (!pareto_journeys.empty() && !pareto_journeys.back().legs.empty()) {
+            legs = pareto_journeys.back().legs;
+            eat = pareto_journeys.back().arrival_time;
             is_raptor_ok = true;
         }
-    } catch (UnknownStation e) {
+    } catch (UnknownStation& e) {
         raptor_error_msg = e.what();
     } catch (...) {
         raptor_error_msg = "unknown error";
@@ -262,6 +329,9 @@ bool compute_journey(JourneyParams const& jparams,
                              rapidjson::Value().SetString(my::format_duration(journey_duration).c_str(), a), a);
     response_field.AddMember("legs", legs_to_json(legs, stops, a), a);
 
+    // all the journeys that are optimal for (arrival time, number of trips), by increasing number of trips :
+    response_field.AddMember("pareto_journeys", pareto_journeys_to_json(pareto_journeys, stops, a), a);
+
     // dumping legs as geojson :
     auto geojson = legs_to_geojson(legs, stops, a);
     response_field.AddMember("geojson", geojson, a);
@@ -269,10 +339,69 @@ bool compute_journey(JourneyParams const& jparams,
     return is_raptor_ok;
 }
 
+// computes all the Pareto-optimal journeys (departure time, arrival time, number of trips) departing in
+// [jparams.departure_time, max_departure_time] :
+bool compute_range(JourneyParams const& jparams,
+                   int max_departure_time,
+                   rapidjson::Value& response_field,
+                   rapidjson::Document::AllocatorType& a,
+                   UltraEnginePool& engines,
+                   myserver::StopMap const& stops,
+                   myserver::StopIds const& stop_ids,
+                   myserver::Metrics& metrics) {
+    response_field.AddMember("journey_params", jparams.as_json(a), a);
+    response_field.AddMember("max_departure_time", max_departure_time, a);
+    response_field.AddMember("max_departure_time_str",
+                             rapidjson::Value().SetString(my::format_time(max_departure_time).c_str(), a), a);
+
+    decltype(chrono::high_resolution_clock::now()) before;
+
+    vector<myserver::ParetoJourney> range_journeys;
+    bool is_raptor_ok = false;
+    string raptor_error_msg = "";
+    try {
+        // the ids are the ranks of the stops in the GTFS data, the engines may use other ids (see StopIds) :
+        Vertex SOURCE = stop_ids.to_internal(jparams.srcid);
+        Vertex TARGET = stop_ids.to_internal(jparams.dstid);
+        auto const sources = to_access_stops(jparams.src_accesses, stop_ids);
+        auto const targets = to_access_stops(jparams.dst_accesses, stop_ids);
+
+        // the engine is only held during the computation (not during the json serialization) :
+        auto engine = engines.acquire();
+        before = chrono::high_resolution_clock::now();
+        if (sources.empty() || targets.empty())
+            range_journeys = engine->runRange(SOURCE, jparams.departure_time, max_departure_time, TARGET);
+        else
+            range_journeys = engine->runRange(sources, jparams.departure_time, max_departure_time, targets);
+        metrics.range.record(engine->getDebugger());
+        for (auto& journey : range_journeys)
+            stop_ids.to_external(journey.legs);
+        is_raptor_ok = true;
+    } catch (UnknownStation& e) {
+        raptor_error_msg = e.what();
+    } catch (...) {
+        raptor_error_msg = "unknown error";
+    }
+
+    auto after = chrono::high_resolution_clock::now();
+
+    auto computing_time_microseconds = chrono::duration_cast<chrono::microseconds>(after - before).count();
+
+    response_field.AddMember("is_ok", is_raptor_ok, a);
+    response_field.AddMember("error_msg", rapidjson::Value().SetString(raptor_error_msg.c_str(), a), a);
+    response_field.AddMember("computing_time_microseconds", computing_time_microseconds, a);
+    response_field.AddMember("nb_journeys", static_cast<uint64_t>(range_journeys.size()), a);
+    response_field.AddMember("journeys", pareto_journeys_to_json(range_journeys, stops, a), a);
+
+    return is_raptor_ok;
+}
+
 void handle_journey_between_stops(const httplib::Request& req,
                                   httplib::Response& res,
-                                  RAPTOR::ULTRARAPTOR<RAPTOR::NoDebugger>& algo,
-                                  myserver::StopMap const& stops) {
+                                  UltraEnginePool& engines,
+                                  myserver::StopMap const& stops,
+                                  myserver::StopIds const& stop_ids,
+                                  myserver::Metrics& metrics) {
     JourneyParams jparams;
     try {
         jparams = parse_stops_params(req.params);
@@ -285,7 +414,7 @@ void handle_journey_between_stops(const httplib::Request& req,
     // if we get here, params are ok :
     rapidjson::Document doc = prepare_response(req, res);
     rapidjson::Document::AllocatorType& a = doc.GetAllocator();
-    bool is_raptor_ok = compute_journey(jparams, doc["response"], a, algo, stops);
+    bool is_raptor_ok = compute_journey(jparams, doc["response"], a, engines, stops, stop_ids, metrics);
     if (is_raptor_ok) {
         finalize_response(res, doc, 200, "");
     } else {
@@ -295,11 +424,58 @@ void handle_journey_between_stops(const httplib::Request& req,
 
 void handle_journey_between_locations(const httplib::Request& req,
                                       httplib::Response& res,
-                                      RAPTOR::ULTRARAPTOR<RAPTOR::NoDebugger>& algo,
-                                      myserver::StopMap const& stops) {
+                                      UltraEnginePool& engines,
+                                      myserver::StopMap const& stops,
+                                      myserver::StopIds const& stop_ids,
+                                      Snapper const& snapper,
+                                      myserver::Metrics& metrics) {
     JourneyParams jparams;
     try {
-        jparams = parse_locations_params(req.params, stops);
+        jparams = parse_locations_params(req.params, stops, stop_ids, snapper);
+    } catch (Error400& e) {
+        rapidjson::Document doc = prepare_response(req, res);
+        finalize_response(res, doc, 400, e.what());
+        return;
+    }
+
+    // if we get here, params are ok :
+    rapidjson::Document doc = prepare_response(req, res);
+    rapidjson::Document::AllocatorType& a = doc.GetAllocator();
+    bool is_raptor_ok = compute_journey(jparams, doc["response"], a, engines, stops, stop_ids, metrics);
+    if (is_raptor_ok) {
+        finalize_response(res, doc, 200, "");
+    } else {
+        finalize_response(res, doc, 500, "raptor encountered an error");
+    }
+}
+
+void handle_range_between_locations(const httplib::Request& req,
+                                    httplib::Response& res,
+                                    UltraEnginePool& engines,
+                                    myserver::StopMap const& stops,
+                                    myserver::StopIds const& stop_ids,
+                                    Snapper const& snapper,
+                                    myserver::Metrics& metrics,
+                                    int max_range_window) {
+    JourneyParams jparams;
+    int max_departure_time;
+    try {
+        jparams = parse_locations_params(req.params, stops, stop_ids, snapper);
+        max_departure_time = get_required_param_as_int(req.params, "max-departure-time");
+        if (max_departure_time < jparams.departure_time) {
+            ostringstream oss;
+            oss << "max-departure-time (" << max_departure_time << ") is before departure-time ("
+                << jparams.departure_time << ")";
+            throw Error400(oss.str());
+        }
+        // one search per departure time of the range, hence the range is bounded (both times are given by the user, the
+        // difference can't be computed as an int) :
+        if (static_cast<int64_t>(max_departure_time) - jparams.departure_time > max_range_window) {
+            ostringstream oss;
+            oss << "the range from departure-time (" << jparams.departure_time << ") to max-departure-time ("
+                << max_departure_time << ") exceeds the maximum of " << max_range_window << " seconds";
+            throw Error400(oss.str());
+        }
     } catch (Error400& e) {
         rapidjson::Document doc = prepare_response(req, res);
         finalize_response(res, doc, 400, e.what());
@@ -309,7 +485,8 @@ void handle_journey_between_locations(const httplib::Request& req,
     // if we get here, params are ok :
     rapidjson::Document doc = prepare_response(req, res);
     rapidjson::Document::AllocatorType& a = doc.GetAllocator();
-    bool is_raptor_ok = compute_journey(jparams, doc["response"], a, algo, stops);
+    bool is_raptor_ok =
+        compute_range(jparams, max_departure_time, doc["response"], a, engines, stops, stop_ids, metrics);
     if (is_raptor_ok) {
         finalize_response(res, doc, 200, "");
     } else {
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "Algorithms/RAPTOR/ULTRARAPTOR.h"
+#include "../engine_pool.h"
+#include "../metrics.h"
+#include "../Snapping/snapping.h"
+#include "../stop_ids.h"
 #include "../stopmap.h"
 
 namespace httplib {
@@ -10,13 +14,30 @@ struct Response;
 
 namespace myserver {
 
+// the engines count the work done by each query, which is aggregated in myserver::Metrics :
+using UltraEnginePool = EnginePool<RAPTOR::ULTRARAPTOR<RAPTOR::CountersDebugger>>;
+
 void handle_journey_between_stops(const httplib::Request&,
                                   httplib::Response&,
-                                  RAPTOR::ULTRARAPTOR<RAPTOR::NoDebugger>&,
-                                  myserver::StopMap const&);
+                                  UltraEnginePool&,
+                                  myserver::StopMap const&,
+                                  myserver::StopIds const&,
+                                  myserver::Metrics&);
 void handle_journey_between_locations(const httplib::Request&,
                                       httplib::Response&,
-                                      RAPTOR::ULTRARAPTOR<RAPTOR::NoDebugger>&,
-                                      myserver::StopMap const&);
+                                      UltraEnginePool&,
+                                      myserver::StopMap const&,
+                                      myserver::StopIds const&,
+                                      Snapper const&,
+                                      myserver::Metrics&);
+// the range (max-departure-time - departure-time) of a request cannot exceed max_range_window seconds :
+void handle_range_between_locations(const httplib::Request&,
+                                    httplib::Response&,
+                                    UltraEnginePool&,
+                                    myserver::StopMap const&,
+                                    myserver::StopIds const&,
+                                    Snapper const&,
+                                    myserver::Metrics&,
+                                    int max_range_window);
 
 }  // namespace myserver
@@ -0,0 +1,11 @@
+#include <httplib.h>
+
+#include "metrics_handler.h"
+
+namespace myserver {
+
+void handle_metrics(const httplib::Request& req, httplib::Response& res, myserver::Metrics const& metrics) {
+    res.set_content(metrics.as_prometheus(), "text/plain; version=0.0.4");
+}
+
+}  // namespace myserver
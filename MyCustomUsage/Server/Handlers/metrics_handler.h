@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../metrics.h"
+
+namespace httplib {
+struct Request;
+struct Response;
+}  // namespace httplib
+
+namespace myserver {
+
+void handle_metrics(const httplib::Request&, httplib::Response&, myserver::Metrics const&);
+
+}
@@ -1,34 +1,49 @@
-#include <boost/geometry.hpp>
+#include <cmath>
+#include <memory>
 
 #include "snapping.h"
 
 namespace myserver {
 
 using namespace std;
-using BgDegree = boost::geometry::cs::spherical_equatorial<boost::geometry::degree>;
-using BgPoint = boost::geometry::model::point<double, 2, BgDegree>;
-using RtreeValue = pair<BgPoint, string>;
-using RTree = boost::geometry::index::rtree<RtreeValue, boost::geometry::index::linear<8>>;
-
-static auto HAVERSINE = boost::geometry::strategy::distance::haversine<double>(6'371'000);
-static RTree rtree;
-
-void build_index(myserver::StopMap stops) {
-    for (auto pair : stops) {
-        auto id = pair.first;
-        auto stop = pair.second;
-        rtree.insert(make_pair(BgPoint{stop.lon, stop.lat}, id));
+
+// the distances computed by Geometry::GeoMetric are in centimeters :
+static constexpr double CM_PER_METER = 100;
+
+Snapper::Snapper(vector<Geometry::Point> const& stop_coordinates,
+                 size_t nb_trees,
+                 size_t max_nb_stops_,
+                 double radius_meters_,
+                 double walkspeed_km_per_hour_)
+    : max_nb_stops{max_nb_stops_},
+      radius_meters{radius_meters_},
+      walkspeed_km_per_hour{walkspeed_km_per_hour_},
+      coordinates{stop_coordinates},
+      trees{nb_trees, [this]() {
+                return make_unique<CoordinateTree<Geometry::GeoMetric>>(Geometry::GeoMetric(), coordinates);
+            }} {}
+
+vector<SnappedStop> Snapper::snap(double lon, double lat) const {
+    Geometry::Point const location(Construct::LatLong, lat, lon);
+    vector<Vertex> stops;
+    {
+        auto tree = trees.acquire();
+        stops = tree->getNearestNeighbors(location, max_nb_stops, radius_meters * CM_PER_METER);
+        if (stops.empty())
+            stops.push_back(tree->getNearestNeighbor(location));
+    }
+
+    vector<SnappedStop> snapped;
+    snapped.reserve(stops.size());
+    for (Vertex const stop : stops) {
+        double const distance_meters = Geometry::geoDistanceInCM(location, coordinates[stop]) / CM_PER_METER;
+        snapped.push_back({stop, static_cast<float>(distance_meters), walking_time(distance_meters)});
     }
+    return snapped;
 }
 
-tuple<string, double, double, float> get_closest_stop(double lon, double lat) {
-    vector<RtreeValue> closest_stops;
-    BgPoint point{lon, lat};
-    rtree.query(boost::geometry::index::nearest(point, 1), back_inserter(closest_stops));
-    auto closest_stop_id = closest_stops.front().second;
-    auto closest_stop_loc = closest_stops.front().first;
-    auto distance = boost::geometry::distance(closest_stop_loc, BgPoint{lon, lat}, HAVERSINE);
-    return make_tuple(closest_stop_id, get<0>(closest_stop_loc), get<1>(closest_stop_loc), distance);
+int Snapper::walking_time(double distance_meters) const {
+    return static_cast<int>(ceil(distance_meters * 3.6 / walkspeed_km_per_hour));
 }
 
 }  // namespace myserver
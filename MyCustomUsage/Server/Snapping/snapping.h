@@ -1,14 +1,53 @@
 #pragma once
 
-#include <string>
-#include <tuple>
+#include <vector>
 
-#include "../stopmap.h"
+#include "DataStructures/Geometry/CoordinateTree.h"
+#include "DataStructures/Geometry/Point.h"
+#include "Helpers/Types.h"
+#include "../engine_pool.h"
 
 namespace myserver {
 
-void build_index(myserver::StopMap);
+// a stop close to a location, and the time needed to walk to it (as the crow flies) :
+struct SnappedStop {
+    Vertex stop;
+    float distance_meters;
+    int walking_time;
+};
 
-std::tuple<std::string, double, double, float> get_closest_stop(double lon, double lat);
+// Snaps a location to the stops around it : the query then starts from (or ends at) all of them at once, each one with
+// its own initial walking time, instead of only using the closest stop.
+class Snapper {
+   public:
+    // the coordinates of the stops, indexed by the ids used by the engines ; nb_trees concurrent queries are possible :
+    Snapper(std::vector<Geometry::Point> const& stop_coordinates,
+            size_t nb_trees,
+            size_t max_nb_stops_ = 8,
+            double radius_meters_ = 500,
+            double walkspeed_km_per_hour_ = 4.5);
+
+    Snapper(Snapper const&) = delete;
+    Snapper& operator=(Snapper const&) = delete;
+
+    // the (at most max_nb_stops) stops within radius_meters of the location, by increasing distance ; if there is no
+    // such stop, only the closest stop is returned (thus, the result is never empty) :
+    std::vector<SnappedStop> snap(double lon, double lat) const;
+
+    inline double get_walkspeed_km_per_hour() const { return walkspeed_km_per_hour; }
+
+   private:
+    int walking_time(double distance_meters) const;
+
+    size_t max_nb_stops;
+    double radius_meters;
+    double walkspeed_km_per_hour;
+
+    // the trees only reference the coordinates, so they have to be declared (thus constructed) first :
+    std::vector<Geometry::Point> coordinates;
+
+    // the queries of CoordinateTree use mutable members, so each request checks out its own tree (like the engines) :
+    mutable EnginePool<CoordinateTree<Geometry::GeoMetric>> trees;
+};
 
 }  // namespace myserver
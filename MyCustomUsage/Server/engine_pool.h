@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace myserver {
+
+// ULTRARAPTOR keeps per-query state (rounds, earliestArrival, bucket-CH labels, ...), so a single instance can't be
+// shared between concurrent requests. This pool owns several engines (all referencing the same immutable RAPTOR::Data,
+// CH::CH and CH::BucketGraphs), and each request checks out one of them for the duration of its computation.
+template <typename Engine>
+class EnginePool {
+   public:
+    // RAII handle : the engine is given back to the pool when the handle is destroyed.
+    class Handle {
+       public:
+        inline Handle(EnginePool& pool_, Engine* engine_) : pool{&pool_}, engine{engine_} {}
+        inline Handle(Handle&& other) : pool{other.pool}, engine{other.engine} { other.engine = nullptr; }
+        Handle(Handle const&) = delete;
+        Handle& operator=(Handle const&) = delete;
+        Handle& operator=(Handle&&) = delete;
+        inline ~Handle() {
+            if (engine != nullptr)
+                pool->release(engine);
+        }
+
+        inline Engine& operator*() const { return *engine; }
+        inline Engine* operator->() const { return engine; }
+
+       private:
+        EnginePool* pool;
+        Engine* engine;
+    };
+
+    // factory is called once per engine, and must return a std::unique_ptr<Engine> :
+    template <typename Factory>
+    inline EnginePool(size_t nb_engines, Factory factory) {
+        engines.reserve(nb_engines);
+        available.reserve(nb_engines);
+        for (size_t i = 0; i < nb_engines; ++i) {
+            engines.push_back(factory());
+            available.push_back(engines.back().get());
+        }
+    }
+
+    EnginePool(EnginePool const&) = delete;
+    EnginePool& operator=(EnginePool const&) = delete;
+
+    // blocks until an engine is available :
+    inline Handle acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        engine_available.wait(lock, [this] { return !available.empty(); });
+        Engine* engine = available.back();
+        available.pop_back();
+        return Handle(*this, engine);
+    }
+
+    inline size_t size() const { return engines.size(); }
+
+   private:
+    inline void release(Engine* engine) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            available.push_back(engine);
+        }
+        engine_available.notify_one();
+    }
+
+    std::vector<std::unique_ptr<Engine>> engines;
+    std::vector<Engine*> available;
+    std::mutex mutex;
+    std::condition_variable engine_available;
+};
+
+}  // namespace myserver
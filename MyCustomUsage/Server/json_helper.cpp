@@ -206,6 +206,29 @@ rapidjson::Value legs_to_geojson(vector<Leg> const& legs, StopMap const& stops,
     return result;
 }
 
+rapidjson::Value pareto_journeys_to_json(vector<ParetoJourney> const& journeys,
+                                         StopMap const& stops,
+                                         rapidjson::Document::AllocatorType& a) {
+    rapidjson::Value json_journeys(rapidjson::kArrayType);
+    for (auto const& journey : journeys) {
+        auto journey_duration = journey.arrival_time - journey.departure_time;
+        rapidjson::Value json_journey(rapidjson::kObjectType);
+        json_journey.AddMember("departure_time", journey.departure_time, a);
+        json_journey.AddMember("departure_time_str",
+                               rapidjson::Value().SetString(my::format_time(journey.departure_time).c_str(), a), a);
+        json_journey.AddMember("arrival_time", journey.arrival_time, a);
+        json_journey.AddMember("arrival_time_str",
+                               rapidjson::Value().SetString(my::format_time(journey.arrival_time).c_str(), a), a);
+        json_journey.AddMember("nb_trips", static_cast<uint64_t>(journey.nb_trips), a);
+        json_journey.AddMember("journey_duration", journey_duration, a);
+        json_journey.AddMember("journey_duration_str",
+                               rapidjson::Value().SetString(my::format_duration(journey_duration).c_str(), a), a);
+        json_journey.AddMember("legs", legs_to_json(journey.legs, stops, a), a);
+        json_journeys.PushBack(json_journey, a);
+    }
+    return json_journeys;
+}
+
 void dump_to_file(rapidjson::Value const& data, string filepath) {
     ofstream out(filepath);
     rapidjson::OStreamWrapper out_wrapper(out);
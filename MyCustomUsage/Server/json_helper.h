@@ -22,6 +22,10 @@ rapidjson::Value legs_to_geojson(std::vector<Leg> const& legs,
                                  StopMap const& stop2loc,
                                  rapidjson::Document::AllocatorType&);
 
+rapidjson::Value pareto_journeys_to_json(std::vector<ParetoJourney> const& journeys,
+                                         StopMap const& stop2loc,
+                                         rapidjson::Document::AllocatorType&);
+
 void dump_to_file(rapidjson::Value const& data, std::string filepath);
 
 }  // namespace myserver
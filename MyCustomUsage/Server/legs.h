@@ -60,4 +60,14 @@ struct Leg {
     }
 };
 
+// one of the Pareto-optimal journeys of a bicriteria or range query (see ULTRARAPTOR::runPareto and runRange) :
+struct ParetoJourney {
+    ParetoJourney(int departure_time_, int arrival_time_, size_t nb_trips_, std::vector<Leg> legs_)
+        : departure_time{departure_time_}, arrival_time{arrival_time_}, nb_trips{nb_trips_}, legs{std::move(legs_)} {}
+    int departure_time;
+    int arrival_time;
+    size_t nb_trips;
+    std::vector<Leg> legs;
+};
+
 }  // namespace myserver
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "Algorithms/RAPTOR/Debugger.h"
+
+namespace myserver {
+
+// Latency histogram with fixed buckets (in microseconds), that can be updated concurrently by all the workers.
+// Prometheus histograms are cumulative, but the buckets are stored separately : a query only increments one of them.
+class LatencyHistogram {
+   public:
+    static constexpr std::array<uint64_t, 16> UPPER_BOUNDS = {10,    25,    50,     100,    250,    500,    1000,    2500,
+                                                              5000,  10000, 25000,  50000,  100000, 250000, 500000, 1000000};
+
+    inline void record(double microseconds) {
+        size_t bucket = 0;
+        while (bucket < UPPER_BOUNDS.size() && microseconds > UPPER_BOUNDS[bucket])
+            ++bucket;
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        sum_nanoseconds.fetch_add(static_cast<uint64_t>(std::llround(microseconds * 1000.0)), std::memory_order_relaxed);
+    }
+
+    // the counters are read one by one : a query recorded during the dump may appear in some lines and not in others.
+    inline void dump(std::ostream& out, std::string const& name, std::string const& labels) const {
+        uint64_t cumulated = 0;
+        for (size_t bucket = 0; bucket < UPPER_BOUNDS.size(); ++bucket) {
+            cumulated += buckets[bucket].load(std::memory_order_relaxed);
+            out << name << "_bucket{" << labels << ",le=\"" << UPPER_BOUNDS[bucket] << "\"} " << cumulated << "\n";
+        }
+        cumulated += buckets.back().load(std::memory_order_relaxed);
+        out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << cumulated << "\n";
+        out << name << "_sum{" << labels << "} " << sum_nanoseconds.load(std::memory_order_relaxed) / 1000.0 << "\n";
+        out << name << "_count{" << labels << "} " << cumulated << "\n";
+    }
+
+   private:
+    // the last bucket is for the queries slower than the last bound :
+    std::array<std::atomic<uint64_t>, UPPER_BOUNDS.size() + 1> buckets{};
+    std::atomic<uint64_t> sum_nanoseconds{0};
+};
+
+// The work done by the queries, in the order of METRICS_COUNTERS :
+enum MetricsCounter : size_t {
+    QUERIES,
+    ROUNDS,
+    SCANNED_ROUTES,
+    SCANNED_ROUTE_SEGMENTS,
+    RELAXED_EDGES,
+    UPDATED_STOPS_BY_ROUTE,
+    UPDATED_STOPS_BY_TRANSFER,
+    NB_METRICS_COUNTERS
+};
+
+// name and description of each counter :
+inline constexpr std::array<std::pair<char const*, char const*>, NB_METRICS_COUNTERS> METRICS_COUNTERS = {{
+    {"ultra_queries_total", "Number of queries."},
+    {"ultra_rounds_total", "Number of RAPTOR rounds."},
+    {"ultra_scanned_routes_total", "Number of scanned routes."},
+    {"ultra_scanned_route_segments_total", "Number of scanned route segments."},
+    {"ultra_relaxed_edges_total", "Number of relaxed shortcut edges."},
+    {"ultra_updated_stops_by_route_total", "Number of arrival times improved by a trip."},
+    {"ultra_updated_stops_by_transfer_total", "Number of arrival times improved by a transfer."},
+}};
+
+// Aggregates the RAPTOR::CountersDebugger of all the queries of one kind (journey, range, ...) : a latency histogram per
+// phase of the search, and the total amount of work done by the queries.
+class QueryMetrics {
+   public:
+    inline void record(RAPTOR::CountersDebugger const& debugger) {
+        initialization.record(debugger.getInitializationTime());
+        initial_transfers.record(debugger.getInitialTransfersTime());
+        collect_routes.record(debugger.getCollectRoutesTime());
+        scan_routes.record(debugger.getScanRoutesTime());
+        intermediate_transfers.record(debugger.getIntermediateTransfersTime());
+        total.record(debugger.getTotalTime());
+        add(QUERIES, 1);
+        add(ROUNDS, debugger.getNumberOfRounds());
+        add(SCANNED_ROUTES, debugger.getNumberOfScannedRoutes());
+        add(SCANNED_ROUTE_SEGMENTS, debugger.getNumberOfScannedRouteSegments());
+        add(RELAXED_EDGES, debugger.getNumberOfRelaxedEdges());
+        add(UPDATED_STOPS_BY_ROUTE, debugger.getNumberOfUpdatedStopsByRoute());
+        add(UPDATED_STOPS_BY_TRANSFER, debugger.getNumberOfUpdatedStopsByTransfer());
+    }
+
+    inline void dump_histograms(std::ostream& out, std::string const& query) const {
+        std::string const name = "ultra_phase_duration_microseconds";
+        initialization.dump(out, name, labels(query, "initialization"));
+        initial_transfers.dump(out, name, labels(query, "initial_transfers"));
+        collect_routes.dump(out, name, labels(query, "collect_routes"));
+        scan_routes.dump(out, name, labels(query, "scan_routes"));
+        intermediate_transfers.dump(out, name, labels(query, "intermediate_transfers"));
+        total.dump(out, name, labels(query, "total"));
+    }
+
+    inline void dump_counter(std::ostream& out, MetricsCounter counter, std::string const& query) const {
+        out << METRICS_COUNTERS[counter].first << "{query=\"" << query << "\"} "
+            << counters[counter].load(std::memory_order_relaxed) << "\n";
+    }
+
+   private:
+    static inline std::string labels(std::string const& query, std::string const& phase) {
+        return "query=\"" + query + "\",phase=\"" + phase + "\"";
+    }
+
+    inline void add(MetricsCounter counter, uint64_t value) {
+        counters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram initialization;
+    LatencyHistogram initial_transfers;
+    LatencyHistogram collect_routes;
+    LatencyHistogram scan_routes;
+    LatencyHistogram intermediate_transfers;
+    LatencyHistogram total;
+
+    std::array<std::atomic<uint64_t>, NB_METRICS_COUNTERS> counters{};
+};
+
+// Performance counters of the server, exposed at /metrics (in the Prometheus text format).
+// Recording a query only costs a few relaxed atomic increments, the engines do the counting (see CountersDebugger).
+class Metrics {
+   public:
+    QueryMetrics journey;
+    QueryMetrics range;
+
+    inline std::string as_prometheus() const {
+        std::ostringstream out;
+        out << "# HELP ultra_phase_duration_microseconds Time spent by the queries in each phase of the search.\n";
+        out << "# TYPE ultra_phase_duration_microseconds histogram\n";
+        journey.dump_histograms(out, "journey");
+        range.dump_histograms(out, "range");
+        for (size_t counter = 0; counter < NB_METRICS_COUNTERS; ++counter) {
+            out << "# HELP " << METRICS_COUNTERS[counter].first << " " << METRICS_COUNTERS[counter].second << "\n";
+            out << "# TYPE " << METRICS_COUNTERS[counter].first << " counter\n";
+            journey.dump_counter(out, MetricsCounter(counter), "journey");
+            range.dump_counter(out, MetricsCounter(counter), "range");
+        }
+        return out.str();
+    }
+};
+
+}  // namespace myserver
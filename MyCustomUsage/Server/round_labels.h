@@ -0,0 +1,163 @@
+#pragma once
+
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Helpers/Types.h"
+
+namespace myserver {
+
+// this structure was originally in Algorithms/RAPTOR/ULTRARAPTOR.h
+// but we need it to be public to be able to properly split the server code
+// it is now only used to expose a (reassembled) label to the journey reconstruction, see RoundLabels below.
+struct EarliestArrivalLabel {
+    EarliestArrivalLabel()
+        : arrivalTime(never), parentDepartureTime(never), parent(noVertex), usesRoute(false), routeId(noRouteId) {}
+    int arrivalTime;
+    int parentDepartureTime;
+    Vertex parent;
+    bool usesRoute;
+    union {
+        RouteId routeId;
+        Edge transferId;
+    };
+
+    std::string as_string() const {
+        std::ostringstream oss;
+        oss << "[";
+        oss << "arrivalTime=" << arrivalTime << "|";
+        oss << "parentDepartureTime=" << parentDepartureTime << "|";
+        oss << "parent=" << parent << "|";
+        oss << "usesRoute=" << usesRoute << "|";
+        oss << "routeId=" << routeId << "|";
+        oss << "transferId=" << transferId << "|";
+        oss << "]";
+        return oss.str();
+    }
+};
+
+// the part of a label that is only needed to rebuild the journey (never read by the RAPTOR scans) :
+struct ParentLabel {
+    ParentLabel() : parentDepartureTime(never), parent(noVertex), usesRoute(false), routeId(noRouteId) {}
+    int parentDepartureTime;
+    Vertex parent;
+    bool usesRoute;
+    union {
+        RouteId routeId;
+        Edge transferId;
+    };
+};
+
+inline constexpr size_t NO_ROUND = std::numeric_limits<size_t>::max();
+
+// Labels of all the rounds of a query, stored as a structure of arrays :
+//   - arrival times of a round are one contiguous array (this is what scanRoutes reads)
+//   - parents are stored in a separate array, with the same layout
+//   - earliest arrival and best round (the round in which the earliest arrival was last improved) of each stop
+// The storage is kept from one query to the next, and only grows when a query needs more rounds than any previous one.
+// Between two queries, only the labels that were actually set are reset (they are tracked in dirty lists).
+class RoundLabels {
+   public:
+    explicit RoundLabels(size_t nb_stops_) : nb_stops{nb_stops_}, nb_rounds{0}, nb_allocated_rounds{0} {
+        earliest_arrival.assign(nb_stops, never);
+        best_round.assign(nb_stops, NO_ROUND);
+    }
+
+    inline void clear() {
+        for (size_t const index : dirty_labels)
+            arrival_times[index] = never;
+        for (Vertex const stop : dirty_stops) {
+            earliest_arrival[stop] = never;
+            best_round[stop] = NO_ROUND;
+        }
+        dirty_labels.clear();
+        dirty_stops.clear();
+        nb_rounds = 0;
+    }
+
+    // starts a new search that reuses the arrival times (and parents) of all rounds of the previous one, as rRAPTOR does
+    // for decreasing departure times : only the earliest arrivals and best rounds are reset.
+    inline void restart() {
+        for (Vertex const stop : dirty_stops) {
+            earliest_arrival[stop] = never;
+            best_round[stop] = NO_ROUND;
+        }
+        dirty_stops.clear();
+        nb_rounds = 0;
+    }
+
+    // the arrival times of the new round are all 'never' (either freshly allocated, or reset by clear) :
+    inline void start_new_round() {
+        if (nb_rounds == nb_allocated_rounds) {
+            ++nb_allocated_rounds;
+            arrival_times.resize(nb_allocated_rounds * nb_stops, never);
+            parents.resize(nb_allocated_rounds * nb_stops);
+        }
+        ++nb_rounds;
+    }
+
+    inline size_t size() const { return nb_rounds; }
+    inline bool empty() const { return nb_rounds == 0; }
+
+    // stays valid until the next call to start_new_round :
+    inline int const* arrival_times_of_round(size_t round) const { return arrival_times.data() + round * nb_stops; }
+
+    inline int arrival_time(size_t round, Vertex stop) const { return arrival_times[round * nb_stops + stop]; }
+    inline int current_arrival_time(Vertex stop) const { return arrival_times[(nb_rounds - 1) * nb_stops + stop]; }
+    inline int earliest_arrival_time(Vertex stop) const { return earliest_arrival[stop]; }
+    inline size_t best_round_of_stop(Vertex stop) const { return best_round[stop]; }
+
+    // sets the arrival time of stop in the current round (the caller checked that it improves both the earliest arrival
+    // and the arrival time of the current round) :
+    inline void update_arrival_time(Vertex stop, int time) {
+        size_t const current_round = nb_rounds - 1;
+        size_t const index = current_round * nb_stops + stop;
+        if (arrival_times[index] == never)
+            dirty_labels.push_back(index);
+        if (earliest_arrival[stop] == never)
+            dirty_stops.push_back(stop);
+        arrival_times[index] = time;
+        earliest_arrival[stop] = time;
+        best_round[stop] = current_round;
+    }
+
+    inline ParentLabel& current_parent(Vertex stop) { return parents[(nb_rounds - 1) * nb_stops + stop]; }
+
+    inline EarliestArrivalLabel label(size_t round, Vertex stop) const {
+        EarliestArrivalLabel result;
+        size_t const index = round * nb_stops + stop;
+        if (arrival_times[index] == never)
+            return result;
+        ParentLabel const& parent = parents[index];
+        result.arrivalTime = arrival_times[index];
+        result.parentDepartureTime = parent.parentDepartureTime;
+        result.parent = parent.parent;
+        result.usesRoute = parent.usesRoute;
+        result.routeId = parent.routeId;
+        return result;
+    }
+
+    inline EarliestArrivalLabel best_label(Vertex stop) const {
+        if (best_round[stop] == NO_ROUND)
+            return {};
+        return label(best_round[stop], stop);
+    }
+
+   private:
+    size_t nb_stops;
+    size_t nb_rounds;
+    size_t nb_allocated_rounds;
+
+    std::vector<int> arrival_times;
+    std::vector<ParentLabel> parents;
+
+    std::vector<int> earliest_arrival;
+    std::vector<size_t> best_round;
+
+    std::vector<size_t> dirty_labels;
+    std::vector<Vertex> dirty_stops;
+};
+
+}  // namespace myserver
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Helpers/Types.h"
+#include "Helpers/Vector/Permutation.h"
+#include "legs.h"
+
+namespace myserver {
+
+// The stop ids exposed by the server are the ranks of the stops in the GTFS data. When the RAPTOR data was renumbered
+// for cache locality (see Runnables/ReorderStops.cpp), the engines use other ids : this table converts between both.
+class StopIds {
+   public:
+    // no renumbering :
+    explicit StopIds(size_t nb_stops) : internal_to_external(nb_stops), external_to_internal(nb_stops) {
+        for (size_t stop = 0; stop < nb_stops; ++stop) {
+            internal_to_external[stop] = stop;
+            external_to_internal[stop] = Vertex(stop);
+        }
+    }
+
+    // the permutation written by ReorderStops maps the GTFS rank of a stop to its new id :
+    explicit StopIds(Permutation const& permutation)
+        : internal_to_external(permutation.size()), external_to_internal(permutation.size()) {
+        for (size_t rank = 0; rank < permutation.size(); ++rank) {
+            internal_to_external[permutation[rank]] = rank;
+            external_to_internal[rank] = Vertex(permutation[rank]);
+        }
+    }
+
+    inline size_t size() const { return external_to_internal.size(); }
+
+    // throws std::invalid_argument or std::out_of_range if the id is not the id of a stop :
+    inline Vertex to_internal(std::string const& external_id) const {
+        return external_to_internal.at(std::stoul(external_id));
+    }
+
+    inline std::string to_external(Vertex internal_id) const {
+        if (internal_id >= internal_to_external.size())
+            return std::to_string(internal_id);
+        return std::to_string(internal_to_external[internal_id]);
+    }
+
+    // the legs built by the engines refer to the internal ids :
+    inline void to_external(std::vector<Leg>& legs) const {
+        auto convert = [this](std::string& id) { id = to_external(Vertex(std::stoul(id))); };
+        for (Leg& leg : legs) {
+            convert(leg.departure_id);
+            convert(leg.arrival_id);
+            for (std::string& stop : leg.stops)
+                convert(stop);
+        }
+    }
+
+   private:
+    std::vector<size_t> internal_to_external;
+    std::vector<Vertex> external_to_internal;
+};
+
+}  // namespace myserver
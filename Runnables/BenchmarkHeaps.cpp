@@ -0,0 +1,201 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../Algorithms/CH/CH.h"
+#include "../DataStructures/Container/ExternalAlignedKHeap.h"
+#include "../DataStructures/Container/ExternalKHeap.h"
+#include "../DataStructures/Container/ExternalRadixHeap.h"
+#include "../DataStructures/RAPTOR/Data.h"
+#include "../Helpers/String/String.h"
+#include "../Helpers/Timer.h"
+#include "../Helpers/Types.h"
+
+// Compares the priority queues on the searches that dominate the preprocessing and the queries: the transfer searches of
+// the shortcut computation (unbounded Dijkstra searches from stops in the transfer graph), and bidirectional CH queries.
+// All queues run exactly the same searches, the checksums (sum of the distances) of the first queue are the reference,
+// which the checksums of every other queue have to match.
+
+struct Label : public ExternalKHeapElement {
+    Label() : distance(INFTY) {}
+    inline bool hasSmallerKey(const Label* const other) const noexcept {
+        return distance < other->distance;
+    }
+    inline int getKey() const noexcept {
+        return distance;
+    }
+    int distance;
+};
+
+struct Result {
+    double milliseconds;
+    long long checksum;
+};
+
+struct Reference {
+    bool isSet = false;
+    long long transferSearches = 0;
+    long long chQueries = 0;
+};
+
+template<typename QUEUE>
+inline Result runTransferSearches(const TransferGraph& graph, const std::vector<Vertex>& sources) noexcept {
+    std::vector<Label> label(graph.numVertices());
+    std::vector<Vertex> reached;
+    QUEUE queue(graph.numVertices());
+    long long checksum = 0;
+    Timer timer;
+    for (const Vertex source : sources) {
+        label[source].distance = 0;
+        reached.emplace_back(source);
+        queue.update(&label[source]);
+        while (!queue.empty()) {
+            const Label* uLabel = queue.extractFront();
+            const Vertex u = Vertex(uLabel - &(label[0]));
+            for (const Edge edge : graph.edgesFrom(u)) {
+                const Vertex v = graph.get(ToVertex, edge);
+                const int newDistance = uLabel->distance + graph.get(TravelTime, edge);
+                if (newDistance >= label[v].distance) continue;
+                if (label[v].distance == INFTY) reached.emplace_back(v);
+                label[v].distance = newDistance;
+                queue.update(&label[v]);
+            }
+        }
+        for (const Vertex vertex : reached) {
+            checksum += label[vertex].distance;
+            label[vertex].distance = INFTY;
+        }
+        reached.clear();
+    }
+    return Result{timer.elapsedMilliseconds(), checksum};
+}
+
+template<typename QUEUE>
+inline Result runCHQueries(const CH::CH& ch, const std::vector<std::pair<Vertex, Vertex>>& queries) noexcept {
+    const CHGraph* graph[2] = {&ch.forward, &ch.backward};
+    std::vector<Label> label[2] = {std::vector<Label>(ch.numVertices()), std::vector<Label>(ch.numVertices())};
+    std::vector<Vertex> reached[2];
+    QUEUE queue[2] = {QUEUE(ch.numVertices()), QUEUE(ch.numVertices())};
+    long long checksum = 0;
+    Timer timer;
+    for (const auto& [source, target] : queries) {
+        const Vertex root[2] = {source, target};
+        for (const int direction : {0, 1}) {
+            label[direction][root[direction]].distance = 0;
+            reached[direction].emplace_back(root[direction]);
+            queue[direction].update(&label[direction][root[direction]]);
+        }
+        int distance = INFTY;
+        while (true) {
+            const int minKey[2] = {queue[0].empty() ? INFTY : queue[0].min().distance, queue[1].empty() ? INFTY : queue[1].min().distance};
+            if (std::min(minKey[0], minKey[1]) >= distance) break;
+            const int direction = (minKey[0] <= minKey[1]) ? 0 : 1;
+            const Label* uLabel = queue[direction].extractFront();
+            const Vertex u = Vertex(uLabel - &(label[direction][0]));
+            distance = std::min(distance, uLabel->distance + label[!direction][u].distance);
+            for (const Edge edge : graph[direction]->edgesFrom(u)) {
+                const Vertex v = graph[direction]->get(ToVertex, edge);
+                const int newDistance = uLabel->distance + graph[direction]->get(Weight, edge);
+                if (newDistance >= label[direction][v].distance) continue;
+                if (label[direction][v].distance == INFTY) reached[direction].emplace_back(v);
+                label[direction][v].distance = newDistance;
+                queue[direction].update(&label[direction][v]);
+            }
+        }
+        if (distance < INFTY) checksum += distance;
+        for (const int direction : {0, 1}) {
+            queue[direction].clear();
+            for (const Vertex vertex : reached[direction]) {
+                label[direction][vertex].distance = INFTY;
+            }
+            reached[direction].clear();
+        }
+    }
+    return Result{timer.elapsedMilliseconds(), checksum};
+}
+
+template<template<typename> class QUEUE>
+inline void benchmark(const std::string& name, const RAPTOR::Data& data, const std::vector<Vertex>& sources, const CH::CH* ch, const std::vector<std::pair<Vertex, Vertex>>& queries, Reference& reference) noexcept {
+    const Result transferSearches = runTransferSearches<QUEUE<Label>>(data.transferGraph, sources);
+    Result chQueries{0, 0};
+    if (ch) chQueries = runCHQueries<QUEUE<Label>>(*ch, queries);
+    if (!reference.isSet) {
+        reference = Reference{true, transferSearches.checksum, chQueries.checksum};
+    }
+    std::cout << name << ":" << std::endl;
+    std::cout << "   transfer searches: " << String::musToString(1000 * transferSearches.milliseconds / sources.size()) << " per search (checksum " << transferSearches.checksum << ")" << std::endl;
+    Ensure(transferSearches.checksum == reference.transferSearches, "MISMATCH: the transfer searches of " << name << " have checksum " << transferSearches.checksum << " instead of " << reference.transferSearches << "!");
+    if (ch) {
+        std::cout << "   CH queries:        " << String::musToString(1000 * chQueries.milliseconds / queries.size()) << " per query (checksum " << chQueries.checksum << ")" << std::endl;
+        Ensure(chQueries.checksum == reference.chQueries, "MISMATCH: the CH queries of " << name << " have checksum " << chQueries.checksum << " instead of " << reference.chQueries << "!");
+    }
+}
+
+template<typename ELEMENT> using BinaryHeap = ExternalKHeap<1, ELEMENT>;
+template<typename ELEMENT> using FourAryHeap = ExternalKHeap<2, ELEMENT>;
+template<typename ELEMENT> using EightAryHeap = ExternalKHeap<3, ELEMENT>;
+template<typename ELEMENT> using AlignedBinaryHeap = ExternalAlignedKHeap<1, ELEMENT>;
+template<typename ELEMENT> using AlignedFourAryHeap = ExternalAlignedKHeap<2, ELEMENT>;
+template<typename ELEMENT> using AlignedEightAryHeap = ExternalAlignedKHeap<3, ELEMENT>;
+
+inline void usage() noexcept {
+    std::cout << "Usage: BenchmarkHeaps <RAPTOR binary> <number of transfer searches> <seed> [CH data] [number of CH queries]" << std::endl;
+    std::cout << "       the transfer searches start at random stops, the CH queries are between random vertices." << std::endl;
+    exit(0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) usage();
+    RAPTOR::Data data = RAPTOR::Data::FromBinary(argv[1]);
+    data.printInfo();
+    const size_t numberOfSearches = String::lexicalCast<size_t>(argv[2]);
+    srand(String::lexicalCast<size_t>(argv[3]));
+    std::vector<Vertex> sources;
+    for (size_t i = 0; i < numberOfSearches; i++) {
+        sources.emplace_back(Vertex(rand() % data.numberOfStops()));
+    }
+    std::unique_ptr<CH::CH> ch;
+    std::vector<std::pair<Vertex, Vertex>> queries;
+    if (argc > 4) {
+        ch = std::make_unique<CH::CH>(argv[4]);
+        const size_t numberOfQueries = (argc > 5) ? String::lexicalCast<size_t>(argv[5]) : 1000;
+        for (size_t i = 0; i < numberOfQueries; i++) {
+            queries.emplace_back(Vertex(rand() % ch->numVertices()), Vertex(rand() % ch->numVertices()));
+        }
+    }
+
+    Reference reference;
+    benchmark<BinaryHeap>("ExternalKHeap, K = 2", data, sources, ch.get(), queries, reference);
+    benchmark<FourAryHeap>("ExternalKHeap, K = 4", data, sources, ch.get(), queries, reference);
+    benchmark<EightAryHeap>("ExternalKHeap, K = 8", data, sources, ch.get(), queries, reference);
+    benchmark<AlignedBinaryHeap>("ExternalAlignedKHeap, K = 2", data, sources, ch.get(), queries, reference);
+    benchmark<AlignedFourAryHeap>("ExternalAlignedKHeap, K = 4", data, sources, ch.get(), queries, reference);
+    benchmark<AlignedEightAryHeap>("ExternalAlignedKHeap, K = 8", data, sources, ch.get(), queries, reference);
+    benchmark<ExternalRadixHeap>("ExternalRadixHeap", data, sources, ch.get(), queries, reference);
+    std::cout << "All queues computed the same distances." << std::endl;
+    return 0;
+}
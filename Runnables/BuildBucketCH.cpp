@@ -26,6 +26,7 @@
 #include "../Algorithms/CH/Preprocessing/KeyFunction.h"
 #include "../Algorithms/CH/Preprocessing/StopCriterion.h"
 #include "../Algorithms/CH/CH.h"
+#include "../Helpers/MultiThreading.h"
 
 using WitnessSearch = CH::BidirectionalWitnessSearch<CHCoreGraph, 500>;
 inline static constexpr int ShortcutWeight = 1024;
@@ -34,15 +35,19 @@ using KeyFunction = CH::GreedyKey<WitnessSearch, ShortcutWeight, LevelWeight, 0>
 using StopCriterion = CH::NoStopCriterion;
 using CHBuilder = CH::Builder<WitnessSearch, KeyFunction, StopCriterion, false, false>;
 
-inline CH::CH buildCH(TravelTimeGraph&& graph) noexcept {
+inline CH::CH buildCH(TravelTimeGraph&& graph, const ThreadPinning& threadPinning) noexcept {
     CHBuilder chBuilder(std::move(graph), graph[TravelTime]);
-    chBuilder.run();
+    if (threadPinning.numberOfThreads > 1) {
+        chBuilder.run(threadPinning);
+    } else {
+        chBuilder.run();
+    }
     chBuilder.copyCoreToCH();
     return CH::CH(std::move(chBuilder));
 }
 
 inline void usage() noexcept {
-    std::cout << "Usage: BuildBucketCH <graph binary> <output file>" << std::endl;
+    std::cout << "Usage: BuildBucketCH <graph binary> <output file> [number of threads] [pin multiplier]" << std::endl;
     exit(0);
 }
 
@@ -52,7 +57,9 @@ int main(int argc, char** argv) {
     TravelTimeGraph transferGraph;
     transferGraph.readBinary(transferGraphFile);
     Graph::printInfo(transferGraph);
-    CH::CH ch = buildCH(std::move(transferGraph));
+    const size_t numberOfThreads = (argc > 3) ? String::lexicalCast<size_t>(argv[3]) : 1;
+    const size_t pinMultiplier = (argc > 4) ? String::lexicalCast<size_t>(argv[4]) : 1;
+    CH::CH ch = buildCH(std::move(transferGraph), ThreadPinning(numberOfThreads, pinMultiplier));
     const std::string outputFile = argv[2];
     ch.writeBinary(outputFile);
     return 0;
@@ -0,0 +1,55 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#include <iostream>
+#include <string>
+
+#include "../Algorithms/CH/CH.h"
+#include "../Algorithms/CH/Query/BucketQuery.h"
+#include "../DataStructures/RAPTOR/Data.h"
+#include "../Helpers/String/String.h"
+#include "../Helpers/Timer.h"
+
+using BucketQuery = CH::BucketQuery<CHGraph, true, false>;
+
+inline void usage() noexcept {
+    std::cout << "Usage: BuildBucketGraphs <RAPTOR binary> <CH data> <output file> [number of threads]" << std::endl;
+    std::cout << "       precomputes the bucket graphs used by the initial/final transfers of ULTRA queries (the stops are the POIs)." << std::endl;
+    exit(0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) usage();
+    const std::string raptorFile = argv[1];
+    RAPTOR::Data data = RAPTOR::Data::FromBinary(raptorFile);
+    data.printInfo();
+    const std::string chFile = argv[2];
+    CH::CH ch(chFile);
+    const std::string outputFile = argv[3];
+    const size_t numberOfThreads = (argc > 4) ? String::lexicalCast<size_t>(argv[4]) : 1;
+
+    std::cout << "Building bucket graphs for " << String::prettyInt(data.numberOfStops()) << " stops (parallel with " << numberOfThreads << " threads)." << std::endl;
+    Timer timer;
+    const CH::BucketGraphs bucketGraphs = BucketQuery::BuildBucketGraphs(ch, data.numberOfStops(), numberOfThreads);
+    std::cout << "Took " << String::msToString(timer.elapsedMilliseconds()) << " (" << String::bytesToString(bucketGraphs.byteSize()) << ")" << std::endl;
+
+    bucketGraphs.writeBinary(outputFile);
+    return 0;
+}
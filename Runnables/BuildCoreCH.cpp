@@ -26,6 +26,7 @@
 #include "../Algorithms/CH/Preprocessing/KeyFunction.h"
 #include "../Algorithms/CH/Preprocessing/StopCriterion.h"
 #include "../Algorithms/CH/CH.h"
+#include "../Helpers/MultiThreading.h"
 #include "../DataStructures/RAPTOR/Data.h"
 
 using WitnessSearch = CH::BidirectionalWitnessSearch<CHCoreGraph, 500>;
@@ -41,7 +42,7 @@ struct CoreCHData {
     RAPTOR::Data coreData;
 };
 
-inline CoreCHData buildCoreCH(const RAPTOR::Data& raptorData, const size_t coreDegree) noexcept {
+inline CoreCHData buildCoreCH(const RAPTOR::Data& raptorData, const size_t coreDegree, const ThreadPinning& threadPinning) noexcept {
     CHCoreGraph graph;
     Graph::copy(raptorData.transferGraph, graph, Weight << TravelTime);
     const size_t numberOfStops = raptorData.numberOfStops();
@@ -49,7 +50,11 @@ inline CoreCHData buildCoreCH(const RAPTOR::Data& raptorData, const size_t coreD
     isNormalVertex.resize(graph.numVertices(), true);
 
     CHBuilder chBuilder(std::move(graph), KeyFunction(isNormalVertex, graph.numVertices()), StopCriterion(numberOfStops, coreDegree));
-    chBuilder.run();
+    if (threadPinning.numberOfThreads > 1) {
+        chBuilder.run(threadPinning);
+    } else {
+        chBuilder.run();
+    }
     chBuilder.copyCoreToCH();
     CH::CH ch(std::move(chBuilder));
 
@@ -70,7 +75,7 @@ inline CoreCHData buildCoreCH(const RAPTOR::Data& raptorData, const size_t coreD
 }
 
 inline void usage() noexcept {
-    std::cout << "Usage: BuildCoreCH <RAPTOR binary> <core degree> <output directory>" << std::endl;
+    std::cout << "Usage: BuildCoreCH <RAPTOR binary> <core degree> <output directory> [number of threads] [pin multiplier]" << std::endl;
     exit(0);
 }
 
@@ -81,7 +86,9 @@ int main(int argc, char** argv) {
     data.useImplicitDepartureBufferTimes();
     data.printInfo();
     const size_t coreDegree = String::lexicalCast<size_t>(argv[2]);
-    CoreCHData contractionData = buildCoreCH(data, coreDegree);
+    const size_t numberOfThreads = (argc > 4) ? String::lexicalCast<size_t>(argv[4]) : 1;
+    const size_t pinMultiplier = (argc > 5) ? String::lexicalCast<size_t>(argv[5]) : 1;
+    CoreCHData contractionData = buildCoreCH(data, coreDegree, ThreadPinning(numberOfThreads, pinMultiplier));
     const std::string outputDirectory = argv[3];
     contractionData.ch.writeBinary(outputDirectory + "ch");
     contractionData.coreData.serialize(outputDirectory + "raptor.binary");
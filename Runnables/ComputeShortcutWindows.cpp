@@ -0,0 +1,102 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../DataStructures/RAPTOR/Data.h"
+#include "../DataStructures/RAPTOR/ShortcutWindows.h"
+#include "../DataStructures/RAPTOR/Stations.h"
+#include "../Helpers/IO/File.h"
+#include "../Helpers/MultiThreading.h"
+#include "../Helpers/String/String.h"
+#include "../Algorithms/ULTRA/Builder.h"
+
+// Reads one window per line: its begin and end (departure times in seconds since midnight).
+inline std::vector<std::pair<int, int>> readWindows(const std::string& fileName) noexcept {
+    std::vector<std::pair<int, int>> windows;
+    IO::IFStream is(fileName);
+    std::string line;
+    while (std::getline(is.getStream(), line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream ss(line);
+        int begin = 0;
+        int end = 0;
+        ss >> begin >> end;
+        Ensure(begin <= end, "Window [" << begin << ", " << end << "] (in " << fileName << ") is empty!");
+        windows.emplace_back(begin, end);
+    }
+    return windows;
+}
+
+template<bool REQUIRE_DIRECT_TRANSFER>
+inline void run(const RAPTOR::Data& data, const std::shared_ptr<const RAPTOR::Stations>& stations, const std::vector<std::pair<int, int>>& windows, const int horizon, const size_t transferLimit, const ThreadPinning& threadPinning, RAPTOR::ShortcutWindows& result) noexcept {
+    for (const auto& [begin, end] : windows) {
+        std::cout << "Computing transfer shortcuts for departures in [" << String::secToTime(begin) << ", " << String::secToTime(end) << "] (searching until " << String::secToTime(end + horizon) << ")." << std::endl;
+        ULTRA::Builder<false, REQUIRE_DIRECT_TRANSFER, true> shortcutGraphBuilder(data);
+        shortcutGraphBuilder.useStations(stations);
+        Timer timer;
+        shortcutGraphBuilder.computeShortcuts(threadPinning, transferLimit, begin, end + horizon);
+        std::cout << "Took " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
+        TransferGraph shortcutGraph;
+        Graph::move(std::move(shortcutGraphBuilder.getShortcutGraph()), shortcutGraph);
+        std::cout << "Number of shortcuts: " << String::prettyInt(shortcutGraph.numEdges()) << std::endl;
+        result.addWindow(begin, end, horizon, std::move(shortcutGraph));
+    }
+}
+
+inline void usage() noexcept {
+    std::cout << "Usage: ComputeShortcutWindows <RAPTOR binary> <transfer limit> <windows file> <horizon> <output file> <number of threads> <pin multiplier> <require direct transfer?>" << std::endl;
+    std::cout << "       the windows file contains one departure time window per line: '<begin> <end>' in seconds since midnight." << std::endl;
+    std::cout << "       the shortcuts of a window are computed for the departures in [begin, end + horizon] (horizon in seconds)," << std::endl;
+    std::cout << "       so that queries departing within the window and arriving before end + horizon are exact." << std::endl;
+    std::cout << "       the server uses the windows if they are written to <shortcuts RAPTOR binary>.windows" << std::endl;
+    exit(0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 9) usage();
+    const std::string raptorFile = argv[1];
+    RAPTOR::Data data = RAPTOR::Data::FromBinary(raptorFile);
+    data.useImplicitDepartureBufferTimes();
+    data.printInfo();
+    const size_t transferLimit = String::lexicalCast<size_t>(argv[2]);
+    const std::vector<std::pair<int, int>> windows = readWindows(argv[3]);
+    const int horizon = String::lexicalCast<int>(argv[4]);
+    const std::string outputFile = argv[5];
+    const ThreadPinning threadPinning(String::lexicalCast<size_t>(argv[6]), String::lexicalCast<size_t>(argv[7]));
+    const bool requireDirectTransfer = String::lexicalCast<bool>(std::string(argv[8]));
+
+    // the stations are the same for all windows :
+    const auto stations = std::make_shared<const RAPTOR::Stations>(RAPTOR::Stations::FromBinaryOrCompute(raptorFile + ".stations", data, threadPinning));
+    RAPTOR::ShortcutWindows shortcutWindows(data);
+    if (requireDirectTransfer) {
+        run<true>(data, stations, windows, horizon, transferLimit, threadPinning, shortcutWindows);
+    } else {
+        run<false>(data, stations, windows, horizon, transferLimit, threadPinning, shortcutWindows);
+    }
+    shortcutWindows.printInfo();
+    shortcutWindows.writeBinary(outputFile);
+    return 0;
+}
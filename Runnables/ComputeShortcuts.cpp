@@ -19,34 +19,66 @@
 **********************************************************************************/
 
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
 
 #include "../DataStructures/RAPTOR/Data.h"
+#include "../DataStructures/RAPTOR/Stations.h"
 #include "../Helpers/MultiThreading.h"
 #include "../Helpers/String/String.h"
 #include "../Algorithms/ULTRA/Builder.h"
 
+// The optional arguments, "-" (or a missing argument) keeps the default :
+struct Options {
+    std::string dependenciesFile = "";
+    size_t maxDeparturesPerTask = std::numeric_limits<size_t>::max();
+    std::string checkpointFile = "";
+    int checkpointInterval = 10 * 60;
+    bool resume = false;
+};
+
 template<bool REQUIRE_DIRECT_TRANSFER>
-inline void run(RAPTOR::Data& data, const size_t numberOfThreads, const size_t pinMultiplier, const size_t transferLimit) noexcept {
-    ULTRA::Builder<false, REQUIRE_DIRECT_TRANSFER> shortcutGraphBuilder(data);
+inline void run(RAPTOR::Data& data, const std::string& stationsFile, const size_t numberOfThreads, const size_t pinMultiplier, const size_t transferLimit, const Options& options) noexcept {
+    ULTRA::Builder<false, REQUIRE_DIRECT_TRANSFER, true> shortcutGraphBuilder(data);
     std::cout << "Computing transfer shortcuts (parallel with " << numberOfThreads << " threads)." << std::endl;
     Timer timer;
-    shortcutGraphBuilder.computeShortcuts(ThreadPinning(numberOfThreads, pinMultiplier), transferLimit);
+    shortcutGraphBuilder.useStations(std::make_shared<const RAPTOR::Stations>(RAPTOR::Stations::FromBinaryOrCompute(stationsFile, data, ThreadPinning(numberOfThreads, pinMultiplier))));
+    if (options.dependenciesFile.empty()) {
+        if (!options.checkpointFile.empty()) shortcutGraphBuilder.useCheckpoint(options.checkpointFile, options.checkpointInterval, options.resume);
+        shortcutGraphBuilder.computeShortcuts(ThreadPinning(numberOfThreads, pinMultiplier), transferLimit, -never, never, true, options.maxDeparturesPerTask);
+    } else {
+        ULTRA::ShortcutDependencies dependencies;
+        shortcutGraphBuilder.computeShortcuts(ThreadPinning(numberOfThreads, pinMultiplier), dependencies, transferLimit);
+        dependencies.serialize(options.dependenciesFile);
+    }
     std::cout << "Took " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
     Graph::move(std::move(shortcutGraphBuilder.getShortcutGraph()), data.transferGraph);
     std::cout << "Number of shortcuts: " << String::prettyInt(data.transferGraph.numEdges()) << std::endl;
 }
 
-inline void chooseRequireDirectTransfer(RAPTOR::Data& data, const size_t numberOfThreads, const size_t pinMultiplier, const size_t transferLimit, const bool requireDirectTransfer) noexcept {
+inline void chooseRequireDirectTransfer(RAPTOR::Data& data, const std::string& stationsFile, const size_t numberOfThreads, const size_t pinMultiplier, const size_t transferLimit, const bool requireDirectTransfer, const Options& options) noexcept {
     if (requireDirectTransfer) {
-        run<true>(data, numberOfThreads, pinMultiplier, transferLimit);
+        run<true>(data, stationsFile, numberOfThreads, pinMultiplier, transferLimit, options);
     } else {
-        run<false>(data, numberOfThreads, pinMultiplier, transferLimit);
+        run<false>(data, stationsFile, numberOfThreads, pinMultiplier, transferLimit, options);
     }
 }
 
+inline bool isGiven(const int argc, char** argv, const int index) noexcept {
+    return (argc > index) && (std::string(argv[index]) != "-");
+}
+
 inline void usage() noexcept {
     std::cout << "Usage: ComputeShortcuts <RAPTOR binary> <transfer limit> <output file> <number of threads> <pin multiplier> <require direct transfer?>" << std::endl;
+    std::cout << "                        [dependencies file] [max departures per task] [checkpoint file] [checkpoint interval in seconds] [resume?]" << std::endl;
+    std::cout << "       optional arguments can be skipped with '-'." << std::endl;
+    std::cout << "       the stations (stops connected by transfers of zero travel time) are read from <RAPTOR binary>.stations if it exists," << std::endl;
+    std::cout << "       otherwise they are computed and written to it." << std::endl;
+    std::cout << "       if a dependencies file is given, it records what UpdateShortcuts needs to update the shortcuts after a timetable change." << std::endl;
+    std::cout << "       stations with more than [max departures per task] departures are searched by several threads (ignored if a dependencies file is given)." << std::endl;
+    std::cout << "       if a checkpoint file is given, the completed stations and their shortcuts are written to it periodically (every 10 minutes by default)," << std::endl;
+    std::cout << "       and with [resume?] = true, the stations completed according to the checkpoint file are skipped (ignored if a dependencies file is given)." << std::endl;
     exit(0);
 }
 
@@ -61,10 +93,20 @@ int main(int argc, char** argv) {
     const size_t numberOfThreads = String::lexicalCast<size_t>(argv[4]);
     const size_t pinMultiplier = String::lexicalCast<size_t>(argv[5]);
     const bool requireDirectTransfer = String::lexicalCast<bool>(argv[6]);
-    chooseRequireDirectTransfer(data, numberOfThreads, pinMultiplier, transferLimit, requireDirectTransfer);
+    Options options;
+    if (isGiven(argc, argv, 7)) options.dependenciesFile = argv[7];
+    if (isGiven(argc, argv, 8)) options.maxDeparturesPerTask = String::lexicalCast<size_t>(argv[8]);
+    Ensure(options.maxDeparturesPerTask > 0, "The max departures per task must be positive!");
+    if (isGiven(argc, argv, 9)) options.checkpointFile = argv[9];
+    if (isGiven(argc, argv, 10)) options.checkpointInterval = String::lexicalCast<int>(argv[10]);
+    if (isGiven(argc, argv, 11)) options.resume = String::lexicalCast<bool>(std::string(argv[11]));
+    chooseRequireDirectTransfer(data, raptorFile + ".stations", numberOfThreads, pinMultiplier, transferLimit, requireDirectTransfer, options);
     data.dontUseImplicitDepartureBufferTimes();
     Graph::printInfo(data.transferGraph);
     data.transferGraph.printAnalysis();
     data.serialize(outputFile);
+    // the mapped data keeps the implicit buffer times of the queries, and records the identity of outputFile :
+    data.useImplicitDepartureBufferTimes();
+    data.serializeMapped(outputFile + ".mapped", outputFile);
     return 0;
 }
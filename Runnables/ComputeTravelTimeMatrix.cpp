@@ -0,0 +1,106 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../Algorithms/CH/CH.h"
+#include "../Algorithms/RAPTOR/Debugger.h"
+#include "../Algorithms/RAPTOR/ULTRARAPTOR.h"
+#include "../DataStructures/RAPTOR/Data.h"
+#include "../Helpers/Console/Progress.h"
+#include "../Helpers/IO/File.h"
+#include "../Helpers/IO/Serialization.h"
+#include "../Helpers/MultiThreading.h"
+#include "../Helpers/String/String.h"
+#include "../Helpers/Timer.h"
+
+using ShortcutRAPTOR = RAPTOR::ULTRARAPTOR<RAPTOR::NoDebugger>;
+
+// Reads one vertex id per line. The keyword "stops" selects all the stops of the network.
+inline std::vector<Vertex> readVertices(const std::string& fileName, const RAPTOR::Data& data, const size_t numberOfVertices) noexcept {
+    std::vector<Vertex> vertices;
+    if (fileName == "stops") {
+        for (const StopId stop : data.stops()) {
+            vertices.emplace_back(stop);
+        }
+        return vertices;
+    }
+    IO::IFStream is(fileName);
+    std::string line;
+    while (std::getline(is.getStream(), line)) {
+        if (line.empty()) continue;
+        const Vertex vertex = Vertex(String::lexicalCast<size_t>(line));
+        Ensure(vertex < numberOfVertices, "Vertex " << vertex << " (in " << fileName << ") is out of range!");
+        vertices.emplace_back(vertex);
+    }
+    return vertices;
+}
+
+inline void usage() noexcept {
+    std::cout << "Usage: ComputeTravelTimeMatrix <RAPTOR binary> <CH data> <origins file> <targets file> <departure time> <output file> <number of threads> <pin multiplier>" << std::endl;
+    std::cout << "       origins and targets files contain one vertex id per line (or are the keyword 'stops')." << std::endl;
+    std::cout << "       the output file contains: departure time, origins, targets, and the travel times (row-major, one row per origin, never if unreachable)." << std::endl;
+    exit(0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 9) usage();
+    const std::string raptorFile = argv[1];
+    RAPTOR::Data data = RAPTOR::Data::FromBinary(raptorFile);
+    data.useImplicitDepartureBufferTimes();
+    data.printInfo();
+    const std::string chFile = argv[2];
+    CH::CH ch(chFile);
+    const size_t numberOfVertices = ch.numVertices();
+    const std::vector<Vertex> origins = readVertices(argv[3], data, numberOfVertices);
+    const std::vector<Vertex> targets = readVertices(argv[4], data, numberOfVertices);
+    const int departureTime = String::lexicalCast<int>(argv[5]);
+    const std::string outputFile = argv[6];
+    const ThreadPinning threadPinning(String::lexicalCast<size_t>(argv[7]), String::lexicalCast<size_t>(argv[8]));
+
+    std::cout << "Computing " << String::prettyInt(origins.size()) << " x " << String::prettyInt(targets.size()) << " travel times (parallel with " << threadPinning.numberOfThreads << " threads)." << std::endl;
+    Timer timer;
+    const auto bucketGraphs = std::make_shared<const CH::BucketGraphs>(CH::BucketQuery<>::BuildBucketGraphs(ch, data.numberOfStops(), threadPinning.numberOfThreads));
+    std::vector<int> travelTimes(origins.size() * targets.size(), never);
+    Progress progress(origins.size());
+    omp_set_num_threads(threadPinning.numberOfThreads);
+    #pragma omp parallel
+    {
+        threadPinning.pinThread();
+        ShortcutRAPTOR algorithm(data, ch, bucketGraphs);
+
+        #pragma omp for schedule(dynamic)
+        for (size_t i = 0; i < origins.size(); i++) {
+            const std::vector<int> arrivalTimes = algorithm.runOneToMany(origins[i], departureTime, targets);
+            for (size_t j = 0; j < targets.size(); j++) {
+                if (arrivalTimes[j] == never) continue;
+                travelTimes[i * targets.size() + j] = arrivalTimes[j] - departureTime;
+            }
+            progress++;
+        }
+    }
+    std::cout << std::endl << "Took " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
+
+    IO::serialize(outputFile, departureTime, origins, targets, travelTimes);
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#include <iostream>
+#include <string>
+
+#include "../Algorithms/CH/CH.h"
+#include "../DataStructures/RAPTOR/Data.h"
+#include "../Helpers/Timer.h"
+#include "../Helpers/String/String.h"
+#include "../Helpers/Vector/Permutation.h"
+
+inline void usage() noexcept {
+    std::cout << "Usage: ReorderStops <RAPTOR binary> <output RAPTOR binary> [CH basename] [output CH basename]" << std::endl;
+    std::cout << "       renumbers the stops and routes so that the stops of a route, close stops, and routes serving the same stops" << std::endl;
+    std::cout << "       have close ids. The transfer graph (e.g. a shortcut graph) and the CH (if given) are renumbered accordingly." << std::endl;
+    std::cout << "       the new id of each stop (resp. route) is written to <output RAPTOR binary>.stopPermutation (resp. .routePermutation)," << std::endl;
+    std::cout << "       the server uses the former to keep exposing the original stop ids." << std::endl;
+    exit(0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || argc == 4) usage();
+    const std::string raptorFile = argv[1];
+    const std::string outputFile = argv[2];
+    // renumbering in place would renumber the data again if the command were repeated :
+    Ensure(outputFile != raptorFile, "The output RAPTOR binary must not be the input one!");
+    if (argc > 4) Ensure(std::string(argv[4]) != std::string(argv[3]), "The output CH must not be the input one!");
+    RAPTOR::Data data = RAPTOR::Data::FromBinary(raptorFile);
+    data.printInfo();
+
+    Timer timer;
+    const Permutation stopPermutation = data.localityPreservingStopPermutation();
+    data.applyStopPermutation(stopPermutation);
+    const Permutation routePermutation = data.localityPreservingRoutePermutation();
+    data.applyRoutePermutation(routePermutation);
+    std::cout << "Renumbered " << String::prettyInt(data.numberOfStops()) << " stops and " << String::prettyInt(data.numberOfRoutes()) << " routes in " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
+    data.serialize(outputFile);
+    stopPermutation.serialize(outputFile + ".stopPermutation");
+    routePermutation.serialize(outputFile + ".routePermutation");
+
+    if (argc > 4) {
+        CH::CH ch(argv[3]);
+        Ensure(ch.numVertices() >= data.numberOfStops(), "The CH does not belong to the RAPTOR data!");
+        ch.applyVertexPermutation(RAPTOR::Data::extendToVertices(stopPermutation, ch.numVertices()));
+        ch.writeBinary(argv[4]);
+    }
+    return 0;
+}
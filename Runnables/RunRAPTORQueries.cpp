@@ -19,6 +19,7 @@
 **********************************************************************************/
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <random>
 
@@ -27,7 +28,9 @@
 #include "../Algorithms/RAPTOR/DijkstraRAPTOR.h"
 #include "../Algorithms/RAPTOR/RAPTOR.h"
 #include "../Algorithms/RAPTOR/ULTRARAPTOR.h"
+#include "../DataStructures/RAPTOR/CompactStopEvents.h"
 #include "../DataStructures/RAPTOR/Data.h"
+#include "../DataStructures/RAPTOR/DepartureColumns.h"
 #include "../Helpers/IO/File.h"
 #include "../Helpers/String/String.h"
 
@@ -147,7 +150,7 @@ inline void runQueries(ALGORITHM& algorithm, const size_t numberOfVertices, cons
 }
 
 inline void usage() noexcept {
-    std::cout << "Usage: RunRAPTORQueries <transfers: transitive/full/shortcuts> <RAPTOR binary> <number of queries> <seed> <output file> <CH data (unless transfers = transitive)>" << std::endl;
+    std::cout << "Usage: RunRAPTORQueries <transfers: transitive/full/shortcuts> <RAPTOR binary> <number of queries> <seed> <output file> <CH data (unless transfers = transitive)> [compact stop events? (transfers = shortcuts)] [departure columns? (transfers = shortcuts)]" << std::endl;
     exit(0);
 }
 
@@ -182,6 +185,16 @@ int main(int argc, char** argv) {
             runQueries<Vertex>(algorithm, data.transferGraph.numVertices(), numberOfQueries, outputFile);
         } else {
             ShortcutRAPTOR algorithm(data, ch);
+            if (argc > 7 && String::lexicalCast<bool>(std::string(argv[7]))) {
+                const auto compactStopEvents = std::make_shared<const RAPTOR::CompactStopEvents>(data);
+                compactStopEvents->printInfo();
+                algorithm.useCompactStopEvents(compactStopEvents);
+            }
+            if (argc > 8 && String::lexicalCast<bool>(std::string(argv[8]))) {
+                const auto departureColumns = std::make_shared<const RAPTOR::DepartureColumns>(data);
+                departureColumns->printInfo();
+                algorithm.useDepartureColumns(departureColumns);
+            }
             runQueries<Vertex>(algorithm, data.transferGraph.numVertices(), numberOfQueries, outputFile);
         }
     }
@@ -0,0 +1,93 @@
+/**********************************************************************************
+
+ Copyright (c) 2019 Jonas Sauer, Tobias Zündorf
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software
+ is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**********************************************************************************/
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../DataStructures/RAPTOR/Data.h"
+#include "../DataStructures/RAPTOR/Stations.h"
+#include "../Helpers/IO/File.h"
+#include "../Helpers/MultiThreading.h"
+#include "../Helpers/String/String.h"
+#include "../Algorithms/ULTRA/Builder.h"
+#include "../Algorithms/ULTRA/ShortcutDependencies.h"
+
+// Reads one route id (of the new timetable) per line.
+inline std::vector<RouteId> readRoutes(const std::string& fileName) noexcept {
+    std::vector<RouteId> routes;
+    IO::IFStream is(fileName);
+    std::string line;
+    while (std::getline(is.getStream(), line)) {
+        if (line.empty()) continue;
+        routes.emplace_back(String::lexicalCast<size_t>(line));
+    }
+    return routes;
+}
+
+template<bool REQUIRE_DIRECT_TRANSFER>
+inline void run(RAPTOR::Data& data, const std::string& stationsFile, ULTRA::ShortcutDependencies& dependencies, const std::vector<RouteId>& changedRoutes, const size_t numberOfThreads, const size_t pinMultiplier) noexcept {
+    ULTRA::Builder<false, REQUIRE_DIRECT_TRANSFER, true> shortcutGraphBuilder(data);
+    shortcutGraphBuilder.useStations(std::make_shared<const RAPTOR::Stations>(RAPTOR::Stations::FromBinaryOrCompute(stationsFile, data, ThreadPinning(numberOfThreads, pinMultiplier))));
+    std::cout << "Updating transfer shortcuts for " << String::prettyInt(changedRoutes.size()) << " changed routes (parallel with " << numberOfThreads << " threads)." << std::endl;
+    Timer timer;
+    shortcutGraphBuilder.updateShortcuts(ThreadPinning(numberOfThreads, pinMultiplier), dependencies, changedRoutes);
+    std::cout << "Took " << String::msToString(timer.elapsedMilliseconds()) << std::endl;
+    Graph::move(std::move(shortcutGraphBuilder.getShortcutGraph()), data.transferGraph);
+    std::cout << "Number of shortcuts: " << String::prettyInt(data.transferGraph.numEdges()) << std::endl;
+}
+
+inline void usage() noexcept {
+    std::cout << "Usage: UpdateShortcuts <RAPTOR binary> <changed routes file> <dependencies file> <output file> <output dependencies file> <number of threads> <pin multiplier>" << std::endl;
+    std::cout << "       the RAPTOR binary is the new timetable (with the same transfer graph as the one given to ComputeShortcuts)," << std::endl;
+    std::cout << "       the changed routes file contains the ids of the routes that were modified, added or removed (one per line)," << std::endl;
+    std::cout << "       and the dependencies file was written by ComputeShortcuts (or by a previous UpdateShortcuts)." << std::endl;
+    std::cout << "       the stations are read from <RAPTOR binary>.stations if it exists, otherwise they are computed and written to it." << std::endl;
+    exit(0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 8) usage();
+    const std::string raptorFile = argv[1];
+    RAPTOR::Data data = RAPTOR::Data::FromBinary(raptorFile);
+    data.useImplicitDepartureBufferTimes();
+    data.printInfo();
+    const std::vector<RouteId> changedRoutes = readRoutes(argv[2]);
+    ULTRA::ShortcutDependencies dependencies(argv[3]);
+    const std::string outputFile = argv[4];
+    const std::string outputDependenciesFile = argv[5];
+    const size_t numberOfThreads = String::lexicalCast<size_t>(argv[6]);
+    const size_t pinMultiplier = String::lexicalCast<size_t>(argv[7]);
+    if (dependencies.requireDirectTransfer) {
+        run<true>(data, raptorFile + ".stations", dependencies, changedRoutes, numberOfThreads, pinMultiplier);
+    } else {
+        run<false>(data, raptorFile + ".stations", dependencies, changedRoutes, numberOfThreads, pinMultiplier);
+    }
+    dependencies.serialize(outputDependenciesFile);
+    data.dontUseImplicitDepartureBufferTimes();
+    Graph::printInfo(data.transferGraph);
+    data.transferGraph.printAnalysis();
+    data.serialize(outputFile);
+    // the mapped data keeps the implicit buffer times of the queries, and records the identity of outputFile :
+    data.useImplicitDepartureBufferTimes();
+    data.serializeMapped(outputFile + ".mapped", outputFile);
+    return 0;
+}
@@ -33,6 +33,11 @@ mkdir -p "$WORKDIR"
 make -C Runnables
 
 
+# all the steps run in parallel with :
+NB_THREADS=4
+PIN_MULTIPLIER=1
+
+
 # STEP 1 = BuildCoreCH 
 #==========
 echo ""
@@ -45,20 +50,40 @@ CORE_DEGREE=14
 Runnables/BuildCoreCH  \
     "${BUILD_CORE_CH_INPUT_DIR}/raptor.binary" \
     "${CORE_DEGREE}" \
-    "${BUILD_CORE_CH_OUTPUT_DIR}/"
+    "${BUILD_CORE_CH_OUTPUT_DIR}/" \
+    "${NB_THREADS}" \
+    "${PIN_MULTIPLIER}"
+
+# STEP 1bis = ReorderStops (renumbers stops and routes for cache locality ; the server keeps exposing the GTFS ranks)
+#==========
+# the renumbered data is written to its own directory, the output of BuildCoreCH is never modified (renumbering it in
+# place twice would permute the stops twice, and the .stopPermutation would no longer match the GTFS ranks) :
+REORDER_STOPS="${REORDER_STOPS:-true}"
+PREPROCESSED_DATA_DIR="${BUILD_CORE_CH_OUTPUT_DIR}"
+if [ "${REORDER_STOPS}" = "true" ]
+then
+    echo ""
+    echo "=== RUNNING ReorderStops"
+    REORDER_STOPS_OUTPUT_DIR="${WORKDIR}/REORDER_STOPS_OUTPUT"
+    mkdir -p "${REORDER_STOPS_OUTPUT_DIR}"
+    Runnables/ReorderStops \
+        "${BUILD_CORE_CH_OUTPUT_DIR}/raptor.binary" \
+        "${REORDER_STOPS_OUTPUT_DIR}/raptor.binary" \
+        "${BUILD_CORE_CH_OUTPUT_DIR}/ch" \
+        "${REORDER_STOPS_OUTPUT_DIR}/ch"
+    PREPROCESSED_DATA_DIR="${REORDER_STOPS_OUTPUT_DIR}"
+fi
 
 
 # STEP 2 = ComputeShortcuts
 #==========
 echo ""
 echo "=== RUNNING ComputeShortcuts"
-COMPUTE_SHORTCUTS_INPUT_DIR="${BUILD_CORE_CH_OUTPUT_DIR}"
+COMPUTE_SHORTCUTS_INPUT_DIR="${PREPROCESSED_DATA_DIR}"
 COMPUTE_SHORTCUTS_OUTPUT_DIR="${WORKDIR}/COMPUTE_SHORTCUTS_OUTPUT"
 COMPUTE_SHORTCUTS_OUTPUT_FILENAME="${COMPUTE_SHORTCUTS_OUTPUT_DIR}/ultra_shortcuts.binary"
 mkdir -p "${COMPUTE_SHORTCUTS_OUTPUT_DIR}"
 TRANSFER_LIMIT=$((15*60))
-NB_THREADS=4
-PIN_MULTIPLIER=1
 REQUIRE_DIRECT_TRANSFERS="true"
 Runnables/ComputeShortcuts \
     "${COMPUTE_SHORTCUTS_INPUT_DIR}/raptor.binary" \
@@ -67,15 +92,50 @@ Runnables/ComputeShortcuts \
     "${NB_THREADS}" \
     "${PIN_MULTIPLIER}" \
     "${REQUIRE_DIRECT_TRANSFERS}"
+if [ "${REORDER_STOPS}" = "true" ]
+then
+    cp "${COMPUTE_SHORTCUTS_INPUT_DIR}/raptor.binary.stopPermutation" "${COMPUTE_SHORTCUTS_OUTPUT_FILENAME}.stopPermutation"
+fi
+
+# STEP 2bis = ComputeShortcutWindows (optional : only if SHORTCUT_WINDOWS_FILE lists departure time windows)
+#==========
+if [ -n "${SHORTCUT_WINDOWS_FILE:-}" ]
+then
+    echo ""
+    echo "=== RUNNING ComputeShortcutWindows"
+    SHORTCUT_WINDOWS_HORIZON="${SHORTCUT_WINDOWS_HORIZON:-$((4*3600))}"
+    Runnables/ComputeShortcutWindows \
+        "${COMPUTE_SHORTCUTS_INPUT_DIR}/raptor.binary" \
+        "${TRANSFER_LIMIT}" \
+        "${SHORTCUT_WINDOWS_FILE}" \
+        "${SHORTCUT_WINDOWS_HORIZON}" \
+        "${COMPUTE_SHORTCUTS_OUTPUT_FILENAME}.windows" \
+        "${NB_THREADS}" \
+        "${PIN_MULTIPLIER}" \
+        "${REQUIRE_DIRECT_TRANSFERS}"
+fi
 
 # STEP 3 = BuildBucketCH
 #==========
 echo ""
 echo "=== RUNNING BuildBucketCH"
-BUILD_BUCKETCH_INPUT_DIR="${BUILD_CORE_CH_OUTPUT_DIR}"
+BUILD_BUCKETCH_INPUT_DIR="${PREPROCESSED_DATA_DIR}"
 BUILD_BUCKETCH_OUTPUT_DIR="${WORKDIR}/BUILD_BUCKETCH_OUTPUT"
 BUILD_BUCKETCH_OUTPUT_FILENAME="${BUILD_BUCKETCH_OUTPUT_DIR}/bucketch.graph"
 mkdir -p "${BUILD_BUCKETCH_OUTPUT_DIR}"
 Runnables/BuildBucketCH \
     "${BUILD_BUCKETCH_INPUT_DIR}/raptor.binary.graph" \
-    "${BUILD_BUCKETCH_OUTPUT_FILENAME}"
+    "${BUILD_BUCKETCH_OUTPUT_FILENAME}" \
+    "${NB_THREADS}" \
+    "${PIN_MULTIPLIER}"
+
+# STEP 4 = BuildBucketGraphs (so that the server doesn't have to build them at startup)
+#==========
+echo ""
+echo "=== RUNNING BuildBucketGraphs"
+BUILD_BUCKETGRAPHS_OUTPUT_FILENAME="${BUILD_BUCKETCH_OUTPUT_FILENAME}.buckets"
+Runnables/BuildBucketGraphs \
+    "${COMPUTE_SHORTCUTS_OUTPUT_FILENAME}" \
+    "${BUILD_BUCKETCH_OUTPUT_FILENAME}" \
+    "${BUILD_BUCKETGRAPHS_OUTPUT_FILENAME}" \
+    "${NB_THREADS}"
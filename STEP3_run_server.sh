@@ -41,8 +41,20 @@ cmake -DCMAKE_BUILD_TYPE=RelWithDebInfo  -B"$BUILD_DIR" -H"$CMAKE_ROOT_DIR"
 make -j -C "$BUILD_DIR" ultra-server
 
 
+# optional server features and limits (see ultra-server usage) :
+SERVER_OPTIONS=()
+COMPACT_STOP_EVENTS="${COMPACT_STOP_EVENTS:-false}"
+[ "${COMPACT_STOP_EVENTS}" = "true" ] && SERVER_OPTIONS+=("--compact-stop-events")
+DEPARTURE_COLUMNS="${DEPARTURE_COLUMNS:-false}"
+[ "${DEPARTURE_COLUMNS}" = "true" ] && SERVER_OPTIONS+=("--departure-columns")
+# maximum range (in seconds) of a /range_between_locations request (the server has a default) :
+MAX_RANGE_WINDOW="${MAX_RANGE_WINDOW:-}"
+[ -n "${MAX_RANGE_WINDOW}" ] && SERVER_OPTIONS+=("--max-range-window=${MAX_RANGE_WINDOW}")
+
+
 # run server :
 "${BUILD_DIR}/bin/ultra-server" \
+    ${SERVER_OPTIONS[@]+"${SERVER_OPTIONS[@]}"} \
     "$SERVER_PORT" \
     "${INPUT_DATA}/COMPUTE_SHORTCUTS_OUTPUT/ultra_shortcuts.binary" \
     "${INPUT_DATA}/BUILD_BUCKETCH_OUTPUT/bucketch.graph"